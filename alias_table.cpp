@@ -0,0 +1,117 @@
+#include "alias_table.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace MiniAutomata
+{
+//#####################################################################################################################
+    AliasTable::AliasTable()
+        : offsets_(1, 0)
+        , probability_{}
+        , alias_{}
+        , small_{}
+        , large_{}
+        , scaled_{}
+    {
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    AliasTable::AliasTable(std::vector <std::size_t> const& offsets, std::vector <double> const& weights)
+        : offsets_{offsets}
+        , probability_(weights.size(), 1.)
+        , alias_(weights.size(), 0)
+        , small_{}
+        , large_{}
+        , scaled_{}
+    {
+        if (offsets_.empty() || offsets_.back() != weights.size())
+            throw std::invalid_argument("alias table offsets do not match the weights");
+
+        for (std::size_t row = 0; row + 1 < offsets_.size(); ++row)
+            assign(row, weights.data() + offsets_[row]);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void AliasTable::assign(std::size_t row, double const* weights)
+    {
+        auto first = offsets_[row];
+        auto count = offsets_[row + 1] - first;
+        if (count == 0)
+            return;
+
+        double total = 0.;
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            if (!(weights[i] > 0.) || !std::isfinite(weights[i]))
+                throw std::invalid_argument("alias table weights must be positive and finite");
+            total += weights[i];
+        }
+
+        // Vose: split columns into those below and above the average, then let large ones fill up small ones.
+        small_.clear();
+        large_.clear();
+        scaled_.resize(count);
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            scaled_[i] = weights[i] * static_cast <double> (count) / total;
+            if (scaled_[i] < 1.)
+                small_.push_back(static_cast <std::uint32_t> (i));
+            else
+                large_.push_back(static_cast <std::uint32_t> (i));
+        }
+
+        while (!small_.empty() && !large_.empty())
+        {
+            auto less = small_.back();
+            small_.pop_back();
+            auto more = large_.back();
+
+            probability_[first + less] = scaled_[less];
+            alias_[first + less] = more;
+
+            scaled_[more] -= 1. - scaled_[less];
+            if (scaled_[more] < 1.)
+            {
+                large_.pop_back();
+                small_.push_back(more);
+            }
+        }
+
+        // leftovers are full columns up to rounding errors.
+        for (auto i : large_)
+        {
+            probability_[first + i] = 1.;
+            alias_[first + i] = i;
+        }
+        for (auto i : small_)
+        {
+            probability_[first + i] = 1.;
+            alias_[first + i] = i;
+        }
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t AliasTable::rowSize(std::size_t row) const
+    {
+        return offsets_[row + 1] - offsets_[row];
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t AliasTable::rowOffset(std::size_t row) const
+    {
+        return offsets_[row];
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    double const* AliasTable::probabilities() const
+    {
+        return probability_.data();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint32_t const* AliasTable::aliases() const
+    {
+        return alias_.data();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t AliasTable::rowCount() const
+    {
+        return offsets_.size() - 1;
+    }
+//#####################################################################################################################
+}
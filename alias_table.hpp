@@ -0,0 +1,99 @@
+#pragma once
+
+#include "random.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace MiniAutomata
+{
+    /**
+     *  Alias tables (Walker/Vose) for many small discrete distributions at once, one per row.
+     *  Rows are laid out like the transitions of a frozen automaton: row i covers the entries
+     *  [offsets[i], offsets[i + 1]). Sampling a row takes constant time regardless of its size.
+     */
+    class AliasTable
+    {
+    public:
+        AliasTable();
+
+        /**
+         *  @param offsets Row boundaries, one more than there are rows.
+         *  @param weights Positive weights of all entries.
+         */
+        AliasTable(std::vector <std::size_t> const& offsets, std::vector <double> const& weights);
+
+        /**
+         *  Replaces the weights of one row. The count must match the row size.
+         */
+        void assign(std::size_t row, double const* weights);
+
+        /**
+         *  Returns the amount of entries in the row.
+         */
+        std::size_t rowSize(std::size_t row) const;
+
+        /**
+         *  Returns the position of the first entry of the row within all entries.
+         */
+        std::size_t rowOffset(std::size_t row) const;
+
+        /**
+         *  Returns the amount of rows.
+         */
+        std::size_t rowCount() const;
+
+        /**
+         *  Draws an entry of a non empty row, with a probability proportional to its weight.
+         *
+         *  @return The position within the row.
+         */
+        template <typename GeneratorT>
+        std::size_t sample(std::size_t row, GeneratorT& generator) const
+        {
+            auto first = offsets_[row];
+            return sample(
+                probability_.data() + first,
+                alias_.data() + first,
+                static_cast <std::uint32_t> (offsets_[row + 1] - first),
+                generator
+            );
+        }
+
+        /**
+         *  Draws from a single non empty row given by its columns, for tables stored elsewhere.
+         *
+         *  @return The position within the row.
+         */
+        template <typename GeneratorT>
+        static std::size_t sample(double const* probability, std::uint32_t const* alias, std::uint32_t count, GeneratorT& generator)
+        {
+            auto column = randomBelow(generator, count);
+            if (randomUnit(generator) < probability[column])
+                return column;
+            return alias[column];
+        }
+
+        /**
+         *  Returns the probability of keeping each column, for all entries.
+         */
+        double const* probabilities() const;
+
+        /**
+         *  Returns the row relative alias of each column, for all entries.
+         */
+        std::uint32_t const* aliases() const;
+
+    private:
+        std::vector <std::size_t> offsets_;
+        std::vector <double> probability_;
+
+        // Row relative position of the entry that fills up the column.
+        std::vector <std::uint32_t> alias_;
+
+        // Scratch space for building rows.
+        std::vector <std::uint32_t> small_;
+        std::vector <std::uint32_t> large_;
+        std::vector <double> scaled_;
+    };
+}
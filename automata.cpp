@@ -1,204 +1,870 @@
-#include "automata.hpp"
-
-#include <stdexcept>
+#include "automata.hpp"
+#include "random.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
 #include <chrono>
-
+#include <type_traits>
+
 namespace MiniAutomata
-{
+{
 	using namespace std::string_literals;
-//#####################################################################################################################
-    Automaton::Automaton()
-        : nameMappings_{}
-        , idMappings_{}
-        , states_{}
-        , currentState_{0}
-        , transitions_{}
-        , randGenerator_{static_cast <unsigned int> (std::chrono::system_clock::now().time_since_epoch().count())}
-    {
-
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    void Automaton::insertMappings()
-    {
-        auto& state = states_.back();
-        nameMappings_.emplace(state.getName(), states_.size() - 1u);
-        auto id = state.getId();
-        if (id)
-            idMappings_.emplace(id.get(), states_.size() - 1u);
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    std::size_t Automaton::getMapped(std::string const& name)
-    {
-        auto iter = nameMappings_.find(name);
-        if (iter != std::end(nameMappings_))
-            return iter->second;
-        else
-            throw std::invalid_argument(("no such state with name '"s + name + "' in automata").c_str());
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    std::size_t Automaton::getMapped(int id)
-    {
-        auto iter = idMappings_.find(id);
-        if (iter != std::end(idMappings_))
-            return iter->second;
-        else
-            throw std::invalid_argument(("no such state with id '"s + std::to_string(id) + "' in automata").c_str());
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    State& Automaton::operator[](std::string const& name)
-    {
-        return states_[getMapped(name)];
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    State& Automaton::operator[](int id)
-    {
-        return states_[getMapped(id)];
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    void Automaton::setState(std::size_t num)
-    {
-        currentState_ = num;
-        states_[currentState_]();
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    TransitionSet Automaton::getActiveTransitions()
-    {
-        TransitionSet result;
-        auto range = transitions_.equal_range(currentState_);
-        for (auto i = range.first; i != range.second; ++i)
-        {
-            if (i->second.test())
-            {
-                result.insert(&i->second);
-            }
-        }
-        return result;
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    void Automaton::seed()
-    {
-        seed(std::chrono::system_clock::now().time_since_epoch().count());
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    bool Automaton::advance()
-    {
-        // advance to a random active transition.
-        return advance([this](TransitionSet const& active) -> TransitionSet::const_iterator {
-            std::uniform_int_distribution<std::size_t> distribution{0, active.size() - 1};
-            auto iter = std::begin(active);
-            std::advance(iter, distribution(randGenerator_));
-            return iter;
-        });
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    boost::optional <std::string> Automaton::getCurrentStateName() const
-    {
-		if (states_.empty())
-			return boost::none;
-        return states_[currentState_].getName();
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    boost::optional <int> Automaton::getCurrentStateId() const
-    {
-		if (states_.empty())
-			return boost::none;
-        return states_[currentState_].getId();
-    }
-//---------------------------------------------------------------------------------------------------------------------
-	std::size_t Automaton::stateCount() const
-	{
-		return states_.size();
-	}
-//---------------------------------------------------------------------------------------------------------------------
-    Automaton::TransitionBegin operator>(Automaton& automat, std::string const& name)
-    {
-        auto num = automat.getMapped(name);
-        return {&automat, num};
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    Automaton::TransitionBegin operator>(Automaton& automat, int id)
-    {
-        auto num = automat.getMapped(id);
-        return {&automat, num};
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    void Automaton::tryEmplace(std::size_t from, std::size_t to, boost::optional <Trigger> const& trig)
-    {
-        // Do not add edges twice.
-        auto range = transitions_.equal_range(from);
-        for (auto i = range.first; i != range.second; ++i)
-            if (i->second.getTarget() == to)
-                return;
-
-        // add edge.
-        transitions_.emplace(from, Transition{this, to, trig});
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    Automaton::TransitionBegin operator>(Automaton::TransitionBegin const& prior, std::string const& name)
-    {
-        auto to = prior.stem->getMapped(name);
-        prior.stem->tryEmplace(prior.from, to, prior.trig);
-        return Automaton::TransitionBegin{prior.stem, to};
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    Automaton::TransitionBegin operator>(Automaton::TransitionBegin const& prior, int id)
-    {
-        auto to = prior.stem->getMapped(id);
-        prior.stem->tryEmplace(prior.from, to, prior.trig);
-        return Automaton::TransitionBegin{prior.stem, to};
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    void operator>(Automaton::TransitionBegin const& prior, ProtoState::StateBinding&& binding)
-    {
-        auto addTransition = [&](auto identification, Trigger const& trig)
-        {
-            auto to = prior.stem->getMapped(identification);
-            if (prior.trig)
-                prior.stem->tryEmplace(
-                    prior.from,
-                    to,
-                    Trigger{[trig, ptrig=prior.trig.get()]() -> bool {return trig.test() && ptrig.test();}}
-                );
-            else
-                prior.stem->tryEmplace(prior.from, to, trig);
-        };
-
-        for (auto const& i : binding)
-        {
-            if (i.id)
-                addTransition(i.id.get(), i.trig);
-            else
-                addTransition(i.name.get(), i.trig);
-        }
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    bool Automaton::advance(std::function <TransitionSet::const_iterator(TransitionSet const& set)> selector)
-    {
-        auto active = getActiveTransitions();
-        if (active.empty())
-            return false;
-
-        if (active.size() == 1)
-        {
-            active.first()->perform();
-            return true;
-        }
-
-        auto iter = selector(active);
-
-        (*iter)->perform();
-        return true;
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    Automaton::TransitionBegin operator>(Automaton::TransitionBegin&& prior, std::function <bool()> const& func)
-    {
-        prior.trig = Trigger{func};
-        return prior;
-    }
-//#####################################################################################################################
-    Automaton makeAutomaton()
-    {
-        return {};
+//#####################################################################################################################
+    namespace
+    {
+        // Followed by the random engine and the hit count of every transition by insertion sequence.
+        struct CheckpointHeader
+        {
+            std::uint64_t stateCount;
+            std::uint64_t transitionCount;
+            std::uint64_t state;
+        };
+
+        static_assert(std::is_trivially_copyable <AutomatonRandom>::value, "the random engine is checkpointed bytewise");
+    }
+//#####################################################################################################################
+    Automaton::Automaton()
+        : nameMappings_{}
+        , idMappings_{}
+        , states_{}
+        , currentState_{0}
+        , transitions_{}
+        , transitionOffsets_{}
+        , frozenTransitions_{}
+        , aliasTable_{}
+        , aliasStale_{false}
+        , active_{}
+        , randGenerator_{static_cast <AutomatonRandom::result_type> (makeSeed())}
+        , adaptive_{false}
+        , instrumentation_{nullptr}
+        , enteredAt_{0}
+        , trace_{nullptr}
+        , traceInstance_{0}
+        , recording_{nullptr}
+        , replay_{nullptr}
+    {
+
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Automaton::Automaton(Automaton const& other)
+        : nameMappings_{other.nameMappings_}
+        , idMappings_{other.idMappings_}
+        , states_{State::copyInterned(other.states_, nameMappings_)}
+        , currentState_{other.currentState_}
+        , transitions_{other.transitions_}
+        , transitionOffsets_{other.transitionOffsets_}
+        , frozenTransitions_{other.frozenTransitions_}
+        , aliasTable_{other.aliasTable_}
+        , aliasStale_{other.aliasStale_}
+        , active_{}
+        , randGenerator_{other.randGenerator_}
+        , adaptive_{other.adaptive_}
+        , instrumentation_{other.instrumentation_}
+        , enteredAt_{other.enteredAt_}
+        , trace_{other.trace_}
+        , traceInstance_{other.traceInstance_}
+        , recording_{nullptr}
+        , replay_{nullptr}
+    {
+        rebind();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Automaton::Automaton(Automaton&& other)
+        : nameMappings_{std::move(other.nameMappings_)}
+        , idMappings_{std::move(other.idMappings_)}
+        , states_{std::move(other.states_)}
+        , currentState_{other.currentState_}
+        , transitions_{std::move(other.transitions_)}
+        , transitionOffsets_{std::move(other.transitionOffsets_)}
+        , frozenTransitions_{std::move(other.frozenTransitions_)}
+        , aliasTable_{std::move(other.aliasTable_)}
+        , aliasStale_{other.aliasStale_}
+        , active_{}
+        , randGenerator_{std::move(other.randGenerator_)}
+        , adaptive_{other.adaptive_}
+        , instrumentation_{other.instrumentation_}
+        , enteredAt_{other.enteredAt_}
+        , trace_{other.trace_}
+        , traceInstance_{other.traceInstance_}
+        , recording_{other.recording_}
+        , replay_{nullptr}
+    {
+        // the moved from automaton stops recording, or both would write into the same recorders.
+        other.detach();
+        rebind();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Automaton& Automaton::operator=(Automaton const& other)
+    {
+        if (this != &other)
+            *this = Automaton{other};
+        return *this;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Automaton& Automaton::operator=(Automaton&& other)
+    {
+        if (this == &other)
+            return *this;
+
+        nameMappings_ = std::move(other.nameMappings_);
+        idMappings_ = std::move(other.idMappings_);
+        states_ = std::move(other.states_);
+        currentState_ = other.currentState_;
+        transitions_ = std::move(other.transitions_);
+        transitionOffsets_ = std::move(other.transitionOffsets_);
+        frozenTransitions_ = std::move(other.frozenTransitions_);
+        aliasTable_ = std::move(other.aliasTable_);
+        aliasStale_ = other.aliasStale_;
+        active_.clear();
+        randGenerator_ = std::move(other.randGenerator_);
+        adaptive_ = other.adaptive_;
+        instrumentation_ = other.instrumentation_;
+        enteredAt_ = other.enteredAt_;
+        trace_ = other.trace_;
+        traceInstance_ = other.traceInstance_;
+        recording_ = other.recording_;
+        replay_ = nullptr;
+        other.detach();
+        rebind();
+        return *this;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::detach()
+    {
+        instrumentation_ = nullptr;
+        trace_ = nullptr;
+        recording_ = nullptr;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::rebind()
+    {
+        for (auto& i : transitions_)
+            i.second.parent_ = this;
+        for (auto& i : frozenTransitions_)
+            i.parent_ = this;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::insertMappings()
+    {
+        thaw();
+        auto& state = states_.back();
+        state.intern(nameMappings_, states_.size() - 1u);
+        auto id = state.getId();
+        if (id)
+            idMappings_.emplace(id.get(), states_.size() - 1u);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t Automaton::getMapped(StringView name)
+    {
+        auto index = nameMappings_.find(name);
+        if (index)
+            return index.get();
+        else
+            throw std::invalid_argument(("no such state with name '"s + name.to_string() + "' in automata").c_str());
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t Automaton::getMapped(int id)
+    {
+        auto iter = idMappings_.find(id);
+        if (iter != std::end(idMappings_))
+            return iter->second;
+        else
+            throw std::invalid_argument(("no such state with id '"s + std::to_string(id) + "' in automata").c_str());
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    State& Automaton::operator[](StringView name)
+    {
+        return states_[getMapped(name)];
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    State& Automaton::operator[](int id)
+    {
+        return states_[getMapped(id)];
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::setState(std::size_t num)
+    {
+        currentState_ = num;
+        if (replay_ == nullptr)
+            states_[currentState_]();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::recordTransition(Transition const& transition)
+    {
+        auto now = Instrumentation::now();
+        if (instrumentation_ != nullptr)
+        {
+            instrumentation_->recordTransition(currentState_, transition.getTarget(), transition.sequence_, now - enteredAt_);
+            enteredAt_ = now;
+        }
+        if (trace_ != nullptr)
+        {
+            trace_->record(TraceRecord{
+                now,
+                traceInstance_,
+                static_cast <std::uint32_t> (currentState_),
+                static_cast <std::uint32_t> (transition.getTarget()),
+                static_cast <std::uint32_t> (transition.sequence_)
+            });
+        }
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    TransitionSet Automaton::getActiveTransitions()
+    {
+        TransitionSet result;
+        SharedPredicate::beginEpoch();
+        collectActiveTransitions(result);
+        return result;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::collectActiveTransitions(TransitionSet& result)
+    {
+        result.clear();
+        if (states_.empty())
+            return;
+
+        forEachTransition(currentState_, [&result](Transition& transition) {
+            if (!transition.getSymbols() && transition.test())
+                result.insert(&transition);
+        });
+        sortUnfrozen(result);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::collectConsumingTransitions(std::uint8_t symbol, TransitionSet& result)
+    {
+        result.clear();
+        if (states_.empty())
+            return;
+
+        forEachTransition(currentState_, [&result, symbol](Transition& transition) {
+            auto const& symbols = transition.getSymbols();
+            if (symbols && symbols->contains(symbol) && transition.test())
+                result.insert(&transition);
+        });
+        sortUnfrozen(result);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::sortUnfrozen(TransitionSet& transitions) const
+    {
+        // the order of unfrozen transitions depends on the standard library, insertion order does not.
+        // frozen transitions are already in precedes() order.
+        if (isFrozen() || transitions.size() < 2)
+            return;
+        std::sort(std::begin(transitions), std::end(transitions), [](Transition const* lhs, Transition const* rhs) {
+            return lhs->sequence_ < rhs->sequence_;
+        });
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::seed()
+    {
+        seed(static_cast <AutomatonRandom::result_type> (std::chrono::system_clock::now().time_since_epoch().count()));
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    AutomatonRandom& Automaton::getRandomGenerator()
+    {
+        return randGenerator_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    TransitionSet::const_iterator Automaton::selectRandom(TransitionSet const& active)
+    {
+        // the active set lists the transitions in slice order, so if none is missing
+        // it lines up with the alias table of the state.
+        if (isFrozen() && active.size() == aliasTable_.rowSize(currentState_))
+        {
+            if (aliasStale_)
+                buildAliasTable();
+            return std::begin(active) + aliasTable_.sample(currentState_, randGenerator_);
+        }
+        return selectWeighted(active);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    TransitionSet::const_iterator Automaton::selectWeighted(TransitionSet const& active)
+    {
+        double total = 0.;
+        for (auto const* transition : active)
+            total += transition->weight_;
+
+        auto remaining = randomUnit(randGenerator_) * total;
+        auto last = std::end(active) - 1;
+        for (auto i = std::begin(active); i != last; ++i)
+        {
+            remaining -= (*i)->weight_;
+            if (remaining < 0.)
+                return i;
+        }
+        return last;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Automaton::advance()
+    {
+        if (recording_ != nullptr)
+            recordStep(RunRecording::Step::advance);
+
+        // advance to a random active transition.
+        return advanceWith([this](TransitionSet const& active) {
+            return selectRandom(active);
+        });
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Automaton::advanceFirstMatch()
+    {
+        if (recording_ != nullptr)
+            recordStep(RunRecording::Step::firstMatch);
+
+        SharedPredicate::beginEpoch();
+        if (states_.empty())
+            return false;
+
+        if (isFrozen())
+        {
+            auto first = transitionOffsets_[currentState_];
+            for (auto i = first; i != transitionOffsets_[currentState_ + 1]; ++i)
+            {
+                auto& transition = frozenTransitions_[i];
+                if (transition.getSymbols() || !transition.test())
+                    continue;
+
+                ++transition.hits_;
+                auto to = transition.getTarget();
+                if (isObserved())
+                    recordTransition(transition);
+                if (adaptive_)
+                    promote(i, first);
+                setState(to);
+                return true;
+            }
+            return false;
+        }
+
+        // unfrozen transitions have no order, sort the candidates before testing.
+        active_.clear();
+        forEachTransition(currentState_, [this](Transition& transition) {
+            if (!transition.getSymbols())
+                active_.insert(&transition);
+        });
+        std::sort(std::begin(active_), std::end(active_), [this](Transition const* lhs, Transition const* rhs) {
+            return precedes(*lhs, *rhs);
+        });
+        for (auto* transition : active_)
+        {
+            if (!transition->test())
+                continue;
+
+            ++transition->hits_;
+            transition->perform();
+            return true;
+        }
+        return false;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::setAdaptiveOrdering(bool enabled)
+    {
+        adaptive_ = enabled;
+        sortFrozen();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Automaton::isAdaptiveOrdering() const
+    {
+        return adaptive_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Automaton::precedes(Transition const& lhs, Transition const& rhs) const
+    {
+        if (lhs.priority_ != rhs.priority_)
+            return lhs.priority_ > rhs.priority_;
+        if (adaptive_ && lhs.hits_ != rhs.hits_)
+            return lhs.hits_ > rhs.hits_;
+        return lhs.sequence_ < rhs.sequence_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::sortFrozen()
+    {
+        for (std::size_t from = 0; from + 1 < transitionOffsets_.size(); ++from)
+        {
+            std::sort(
+                std::begin(frozenTransitions_) + transitionOffsets_[from],
+                std::begin(frozenTransitions_) + transitionOffsets_[from + 1],
+                [this](Transition const& lhs, Transition const& rhs) {
+                    return precedes(lhs, rhs);
+                }
+            );
+        }
+        buildAliasTable();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::buildAliasTable()
+    {
+        std::vector <std::size_t> offsets(1, 0);
+        std::vector <double> weights;
+        for (std::size_t from = 0; from + 1 < transitionOffsets_.size(); ++from)
+        {
+            for (auto i = transitionOffsets_[from]; i != transitionOffsets_[from + 1]; ++i)
+                if (!frozenTransitions_[i].getSymbols())
+                    weights.push_back(frozenTransitions_[i].weight_);
+            offsets.push_back(weights.size());
+        }
+        aliasTable_ = AliasTable{offsets, weights};
+        aliasStale_ = false;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::promote(std::size_t position, std::size_t first)
+    {
+        // only the hits of this transition grew, so moving it forward restores the order.
+        for (; position != first && precedes(frozenTransitions_[position], frozenTransitions_[position - 1]); --position)
+        {
+            std::swap(frozenTransitions_[position], frozenTransitions_[position - 1]);
+            aliasStale_ = true;
+        }
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Automaton::consume(std::uint8_t symbol)
+    {
+        if (recording_ != nullptr)
+            recordStep(RunRecording::Step::consume, symbol);
+
+        SharedPredicate::beginEpoch();
+        collectConsumingTransitions(symbol, active_);
+        if (active_.empty())
+            return false;
+
+        if (active_.size() == 1)
+        {
+            active_.first()->perform();
+            return true;
+        }
+
+        Transition* chosen = *selectWeighted(active_);
+        if (recording_ != nullptr)
+            recordChoice(*chosen);
+        else if (replay_ != nullptr)
+            chosen = replayChoice(active_);
+        chosen->perform();
+        return true;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t Automaton::consume(std::uint8_t const* data, std::size_t size)
+    {
+        for (std::size_t i = 0; i != size; ++i)
+            if (!consume(data[i]))
+                return i;
+        return size;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    boost::optional <StringView> Automaton::getCurrentStateName() const
+    {
+		if (states_.empty())
+			return boost::none;
+        return states_[currentState_].getName();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t Automaton::getCurrentStateIndex() const
+    {
+        return currentState_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    boost::optional <std::size_t> Automaton::findState(StringView name) const
+    {
+        return nameMappings_.find(name);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    boost::optional <int> Automaton::getCurrentStateId() const
+    {
+		if (states_.empty())
+			return boost::none;
+        return states_[currentState_].getId();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::setCurrentState(std::size_t index)
+    {
+        if (index >= states_.size())
+            throw std::invalid_argument(("no such state with index '"s + std::to_string(index) + "' in automata").c_str());
+        currentState_ = index;
+        if (instrumentation_ != nullptr)
+            enteredAt_ = Instrumentation::now();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t Automaton::checkpointSize() const
+    {
+        return sizeof(CheckpointHeader) + sizeof(AutomatonRandom) + transitionCount() * sizeof(std::uint64_t);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::checkpoint(void* buffer) const
+    {
+        auto* out = static_cast <char*> (buffer);
+        CheckpointHeader header{
+            states_.size(),
+            transitionCount(),
+            currentState_
+        };
+        std::memcpy(out, &header, sizeof(header));
+        std::memcpy(out + sizeof(header), &randGenerator_, sizeof(AutomatonRandom));
+
+        // by sequence, so the order does not depend on freezing or adaptive reordering.
+        auto* hits = out + sizeof(header) + sizeof(AutomatonRandom);
+        for (std::size_t from = 0; from != states_.size(); ++from)
+        {
+            forEachTransition(from, [hits](Transition const& transition) {
+                std::uint64_t count = transition.hits_;
+                std::memcpy(hits + transition.sequence_ * sizeof(std::uint64_t), &count, sizeof(count));
+            });
+        }
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::restore(void const* buffer, std::size_t size)
+    {
+        auto const* in = static_cast <char const*> (buffer);
+        CheckpointHeader header;
+        if (size < sizeof(header))
+            throw std::invalid_argument("checkpoint is truncated");
+        std::memcpy(&header, in, sizeof(header));
+
+        if (header.stateCount != states_.size() || size != checkpointSize() || header.state >= states_.size())
+            throw std::invalid_argument("checkpoint does not fit the states and transitions of this automaton");
+
+        currentState_ = static_cast <std::size_t> (header.state);
+        if (instrumentation_ != nullptr)
+            enteredAt_ = Instrumentation::now();
+        std::memcpy(&randGenerator_, in + sizeof(header), sizeof(AutomatonRandom));
+
+        auto const* hits = in + sizeof(header) + sizeof(AutomatonRandom);
+        for (std::size_t from = 0; from != states_.size(); ++from)
+        {
+            forEachTransition(from, [hits](Transition& transition) {
+                std::uint64_t count;
+                std::memcpy(&count, hits + transition.sequence_ * sizeof(std::uint64_t), sizeof(count));
+                transition.hits_ = count;
+            });
+        }
+
+        if (isFrozen() && adaptive_)
+            sortFrozen();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+	std::size_t Automaton::stateCount() const
+	{
+		return states_.size();
+	}
+//---------------------------------------------------------------------------------------------------------------------
+    bool Automaton::isQuiescent() const
+    {
+        if (states_.empty())
+            return true;
+
+        bool quiescent = true;
+        forEachTransition(currentState_, [&quiescent](Transition const& transition) {
+            quiescent = quiescent && (transition.getSymbols() || transition.isDormant());
+        });
+        return quiescent;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::freeze()
+    {
+        if (isFrozen())
+            return;
+
+        frozenTransitions_.clear();
+        frozenTransitions_.reserve(transitions_.size());
+        transitionOffsets_.resize(states_.size() + 1);
+        for (std::size_t from = 0; from != states_.size(); ++from)
+        {
+            transitionOffsets_[from] = frozenTransitions_.size();
+            auto range = transitions_.equal_range(from);
+            for (auto i = range.first; i != range.second; ++i)
+                frozenTransitions_.push_back(std::move(i->second));
+        }
+        transitionOffsets_[states_.size()] = frozenTransitions_.size();
+        transitions_.clear();
+        sortFrozen();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::thaw()
+    {
+        if (!isFrozen())
+            return;
+
+        transitions_.reserve(frozenTransitions_.size());
+        for (std::size_t from = 0; from + 1 < transitionOffsets_.size(); ++from)
+            for (auto i = transitionOffsets_[from]; i != transitionOffsets_[from + 1]; ++i)
+                transitions_.emplace(from, std::move(frozenTransitions_[i]));
+
+        transitionOffsets_.clear();
+        frozenTransitions_.clear();
+        aliasTable_ = AliasTable{};
+        aliasStale_ = false;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Automaton::isFrozen() const
+    {
+        return !transitionOffsets_.empty();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t Automaton::transitionCount() const
+    {
+        return isFrozen() ? frozenTransitions_.size() : transitions_.size();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::setInstrumentation(Instrumentation* instrumentation)
+    {
+        instrumentation_ = instrumentation;
+        enteredAt_ = instrumentation_ != nullptr ? Instrumentation::now() : 0;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Instrumentation* Automaton::getInstrumentation() const
+    {
+        return instrumentation_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::setTraceRecorder(TraceRecorder* recorder, std::uint64_t instance)
+    {
+        trace_ = recorder;
+        traceInstance_ = instance;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    TraceRecorder* Automaton::getTraceRecorder() const
+    {
+        return trace_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::startRecording(RunRecording& recording)
+    {
+        if (replay_ != nullptr)
+            throw std::invalid_argument("cannot record while replaying");
+
+        recording.clear();
+        recording.start_.resize(checkpointSize());
+        checkpoint(recording.start_.data());
+        recording_ = &recording;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::stopRecording()
+    {
+        if (recording_ == nullptr)
+            return;
+
+        recording_->states_.push_back(static_cast <std::uint32_t> (currentState_));
+        recording_->outcomeOffsets_.push_back(recording_->outcomes_.size());
+        recording_ = nullptr;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::recordStep(RunRecording::Step step, std::uint8_t symbol)
+    {
+        recording_->steps_.push_back(step);
+        recording_->states_.push_back(static_cast <std::uint32_t> (currentState_));
+        recording_->outcomeOffsets_.push_back(recording_->outcomes_.size());
+        if (step == RunRecording::Step::consume)
+            recording_->symbols_.push_back(symbol);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::recordChoice(Transition const& chosen)
+    {
+        recording_->choices_.push_back(static_cast <std::uint32_t> (chosen.sequence_));
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Automaton::replayOutcome(Transition const& transition)
+    {
+        auto outcome = replay_->recording->findOutcome(replay_->step, transition.sequence_);
+        if (!outcome)
+        {
+            replay_->diverged = true;
+            return false;
+        }
+        return outcome.get();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Transition* Automaton::replayChoice(TransitionSet const& active)
+    {
+        auto const& choices = replay_->recording->choices_;
+        if (replay_->choice != choices.size())
+        {
+            auto sequence = choices[replay_->choice++];
+            for (auto* transition : active)
+                if (transition->sequence_ == sequence)
+                    return transition;
+        }
+        replay_->diverged = true;
+        return *std::begin(active);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    ReplayResult Automaton::replay(RunRecording const& recording)
+    {
+        if (recording_ != nullptr)
+            throw std::invalid_argument("cannot replay while recording");
+        if (recording.states_.size() != recording.steps_.size() + 1 || recording.outcomeOffsets_.size() != recording.states_.size())
+            throw std::invalid_argument("run recording is incomplete, recording was not stopped");
+        restore(recording.start_.data(), recording.start_.size());
+
+        ReplayCursor cursor{&recording, 0, 0, false};
+        ReplayResult result{0, boost::none};
+        std::size_t symbol = 0;
+        replay_ = &cursor;
+        try
+        {
+            for (std::size_t step = 0; step != recording.steps_.size(); ++step)
+            {
+                cursor.step = step;
+                switch (recording.steps_[step])
+                {
+                    case RunRecording::Step::advance:
+                        advance();
+                        break;
+                    case RunRecording::Step::select:
+                        // the recorded choice replaces whatever the selector returns.
+                        advanceWith([](TransitionSet const& active) {
+                            return std::begin(active);
+                        });
+                        break;
+                    case RunRecording::Step::firstMatch:
+                        advanceFirstMatch();
+                        break;
+                    case RunRecording::Step::consume:
+                        if (symbol == recording.symbols_.size())
+                            throw std::invalid_argument("run recording is corrupt");
+                        consume(recording.symbols_[symbol++]);
+                        break;
+                }
+
+                result.steps = step + 1;
+                if (cursor.diverged || currentState_ != recording.states_[step + 1])
+                {
+                    result.divergence = step;
+                    break;
+                }
+            }
+        }
+        catch (...)
+        {
+            replay_ = nullptr;
+            throw;
+        }
+        replay_ = nullptr;
+        return result;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Automaton::TransitionBegin operator>(Automaton& automat, StringView name)
+    {
+        auto num = automat.getMapped(name);
+        return {&automat, num};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Automaton::TransitionBegin operator>(Automaton& automat, int id)
+    {
+        auto num = automat.getMapped(id);
+        return {&automat, num};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Automaton::tryEmplace(
+        std::size_t from,
+        std::size_t to,
+        boost::optional <Trigger> const& trig,
+        boost::optional <SymbolSet> const& symbols,
+        int priority,
+        double weight
+    )
+    {
+        thaw();
+
+        // Do not add edges twice. Labeled edges to the same state are merged, if they only differ in their symbols.
+        // Guarded ones are never merged, there is no telling whether two conditions are the same.
+        auto range = transitions_.equal_range(from);
+        for (auto i = range.first; i != range.second; ++i)
+        {
+            auto& existing = i->second;
+            if (existing.getTarget() != to || static_cast <bool> (existing.symbols_) != static_cast <bool> (symbols))
+                continue;
+            if (symbols)
+            {
+                bool unconditional = existing.trigger_.isUnconditional() && (!trig || trig->isUnconditional());
+                if (
+                    !unconditional ||
+                    existing.symbols_->isEpsilon() != symbols->isEpsilon() ||
+                    existing.priority_ != priority ||
+                    existing.weight_ != weight
+                )
+                    continue;
+                existing.symbols_->add(symbols.get());
+            }
+            return;
+        }
+
+        // add edge. Edges are never removed, so the count is a unique insertion sequence.
+        Transition transition{this, to, trig, symbols};
+        transition.priority_ = priority;
+        transition.weight_ = weight;
+        transition.sequence_ = transitions_.size();
+        transitions_.emplace(from, std::move(transition));
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Automaton::TransitionBegin operator>(Automaton::TransitionBegin const& prior, StringView name)
+    {
+        auto to = prior.stem->getMapped(name);
+        prior.stem->tryEmplace(prior.from, to, prior.trig, prior.symbols, prior.priority, prior.weight);
+        return Automaton::TransitionBegin{prior.stem, to};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Automaton::TransitionBegin operator>(Automaton::TransitionBegin const& prior, int id)
+    {
+        auto to = prior.stem->getMapped(id);
+        prior.stem->tryEmplace(prior.from, to, prior.trig, prior.symbols, prior.priority, prior.weight);
+        return Automaton::TransitionBegin{prior.stem, to};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void operator>(Automaton::TransitionBegin const& prior, ProtoState::StateBinding&& binding)
+    {
+        auto addTransition = [&](auto identification, Trigger const& trig)
+        {
+            auto to = prior.stem->getMapped(identification);
+            if (prior.trig)
+                prior.stem->tryEmplace(prior.from, to, trig && prior.trig.get(), prior.symbols, prior.priority, prior.weight);
+            else
+                prior.stem->tryEmplace(prior.from, to, trig, prior.symbols, prior.priority, prior.weight);
+        };
+
+        for (auto const& i : binding)
+        {
+            if (i.id)
+                addTransition(i.id.get(), i.trig);
+            else
+                addTransition(i.name.get(), i.trig);
+        }
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Automaton::TransitionBegin operator>(Automaton::TransitionBegin&& prior, std::function <bool()> const& func)
+    {
+        prior.trig = Trigger{func};
+        return prior;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Automaton::TransitionBegin operator>(Automaton::TransitionBegin&& prior, Trigger const& trig)
+    {
+        prior.trig = trig;
+        return prior;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Automaton::TransitionBegin operator>(Automaton::TransitionBegin&& prior, SymbolSet const& symbols)
+    {
+        prior.symbols = symbols;
+        return prior;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Automaton::TransitionBegin operator>(Automaton::TransitionBegin&& prior, Priority priority)
+    {
+        prior.priority = priority.value;
+        return prior;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Automaton::TransitionBegin operator>(Automaton::TransitionBegin&& prior, Weight weight)
+    {
+        if (!(weight.value > 0.) || !std::isfinite(weight.value))
+            throw std::invalid_argument("transition weight must be positive and finite");
+        prior.weight = weight.value;
+        return prior;
+    }
+//#####################################################################################################################
+    Automaton makeAutomaton()
+    {
+        return {};
     }
 //#####################################################################################################################
-}
+}
@@ -1,186 +1,522 @@
-#pragma once
-
-#include "automata_fwd.hpp"
-#include "state.hpp"
-#include "transition.hpp"
-
-#include <utility>
-#include <vector>
-#include <unordered_map>
-#include <random>
-
-namespace MiniAutomata
-{
-    /**
-     *  A finite state (non)deterministic automaton.
-     */
-    class Automaton
-    {
-    public:
-        friend Transition;
-
-        struct TransitionBegin
-        {
-            Automaton* stem;
-            std::size_t from;
-            boost::optional <Trigger> trig;
-
-            TransitionBegin(Automaton* stem, std::size_t from, boost::optional <Trigger> trig)
-                : stem{stem}
-                , from{from}
-                , trig{trig}
-            {}
-
-            TransitionBegin(Automaton* stem, std::size_t from)
-                : stem{stem}
-                , from{from}
-                , trig{boost::none}
-            {}
-        };
-
-    public:
-        Automaton();
-
-        /**
-         *  Seeds the random engine.
-         */
-        template <typename T>
-        void seed(T const& seed)
-        {
-            randGenerator_.seed(seed);
-        }
-
-        /**
-         *  Seeds the random engine with time.
-         */
-        void seed();
-
-        /**
-         *  operator<< to insert states into the automata
-         */
-        template <typename T>
-        typename std::enable_if <std::is_same <typename std::decay <T>::type, State>::value, Automaton&>::type
-        operator<<(T&& state)
-        {
-            states_.push_back(std::forward <T&&>(state));
-            insertMappings();
-            return *this;
-        }
-
-        /**
-         *  operator<< to insert id-less states into the automata
-         */
-        template <typename T>
-        typename std::enable_if <std::is_same <typename std::decay <T>::type, ProtoState>::value, Automaton&>::type
-        operator<<(T&& state)
-        {
-            return operator<<(std::move(std::forward <T&&> (state)()));
-        }
-
-        /**
-         *  operator<< to insert states into the automata
-         */
-        Automaton& operator<<(const char* cstr)
-        {
-            return operator<<(ProtoState{cstr}());
-        }
-
-        /**
-         *  operator[] to retrieve state elements by name.
-         */
-        State& operator[](std::string const& name);
-
-        /**
-         *  operator[] to retrieve state elements by id.
-         */
-        State& operator[](int id);
-
-        /**
-         *  Test for any transition conditions becoming true.
-         */
-        TransitionSet getActiveTransitions();
-
-        /**
-         *  Inserts Transitions.
-         */
-        friend TransitionBegin operator>(Automaton& automat, std::string const& name);
-
-        /**
-         *  Inserts transitions.
-         */
-        friend TransitionBegin operator>(Automaton& automat, int id);
-
-        /**
-         *  Inserts transitions.
-         */
-        friend TransitionBegin operator>(TransitionBegin const& prior, std::string const& name);
-
-        /**
-         *  Inserts transitions.
-         */
-        friend TransitionBegin operator>(TransitionBegin const& prior, int id);
-
-        /**
-         *  Inserts transitions.
-         */
-        friend void operator>(TransitionBegin const& prior, ProtoState::StateBinding&& binding);
-
-        /**
-         *  Sets trigger for transition.
-         */
-        friend TransitionBegin operator>(TransitionBegin&& prior, std::function <bool()> const& func);
-
-        /**
-         *  Returns the name of the current state
-         */
-        boost::optional <std::string> getCurrentStateName() const;
-
-        /**
-         *  Returns the name of the current state
-         */
-        boost::optional <int> getCurrentStateId() const;
-
-        /**
-         *  Transition to the next state, if possible. Selects a random transition, if multiple are active.
-         *
-         *  @return Returns true, if a transition has been made.
-         */
-        bool advance();
-
-        /**
-         *  Transition to the next state, if possible. Calls the selector function, if multiple are active.
-         *
-         *  @return Returns true, if a transition has been made.
-         */
-        bool advance(std::function <TransitionSet::const_iterator(TransitionSet const& set)> selector);
-		
-		/**
-		 *	Returns the amout of states.
-		 */
-		std::size_t stateCount() const;
-
-    private:
-        void tryEmplace(std::size_t from, std::size_t to, boost::optional <Trigger> const& trig);
-        void insertMappings();
-        void setState(std::size_t num);
-        std::size_t getMapped(std::string const& name);
-        std::size_t getMapped(int id);
-
-    private:
-        // Mappings
-        std::unordered_map <std::string, std::size_t> nameMappings_;
-        std::unordered_map <int, std::size_t> idMappings_;
-
-        // Can only grow, cannot shrink
-        std::vector <State> states_;
-
-        std::size_t currentState_;
-
-        // Edges / Transitions
-        std::unordered_multimap <std::size_t, Transition> transitions_;
-
-        std::mt19937 randGenerator_;
-    };
-
-    Automaton makeAutomaton();
-}
+#pragma once
+
+#include "automata_fwd.hpp"
+#include "state.hpp"
+#include "transition.hpp"
+#include "predicate.hpp"
+#include "alias_table.hpp"
+#include "random.hpp"
+#include "names.hpp"
+#include "instrumentation.hpp"
+#include "trace.hpp"
+#include "replay.hpp"
+#include "symbols.hpp"
+#include "definition.hpp"
+#include "batch.hpp"
+#include "runner.hpp"
+#include "dfa.hpp"
+#include "nfa.hpp"
+#include "determinize.hpp"
+#include "lazy_dfa.hpp"
+#include "markov.hpp"
+#include "walks.hpp"
+#include "static_automaton.hpp"
+#include "builder.hpp"
+#include "mapped_definition.hpp"
+
+#include <utility>
+#include <vector>
+#include <unordered_map>
+
+namespace MiniAutomata
+{
+    /**
+     *  A finite state (non)deterministic automaton.
+     */
+    class Automaton
+    {
+    public:
+        friend Transition;
+        friend AutomatonDefinition;
+        friend AutomatonBuilder;
+
+        struct TransitionBegin
+        {
+            Automaton* stem;
+            std::size_t from;
+            boost::optional <Trigger> trig;
+            boost::optional <SymbolSet> symbols;
+            int priority;
+            double weight;
+
+            TransitionBegin(Automaton* stem, std::size_t from, boost::optional <Trigger> trig)
+                : stem{stem}
+                , from{from}
+                , trig{trig}
+                , symbols{boost::none}
+                , priority{0}
+                , weight{1.}
+            {}
+
+            TransitionBegin(Automaton* stem, std::size_t from)
+                : stem{stem}
+                , from{from}
+                , trig{boost::none}
+                , symbols{boost::none}
+                , priority{0}
+                , weight{1.}
+            {}
+        };
+
+    public:
+        Automaton();
+
+        /**
+         *  Copies rebind all transitions to the new automaton.
+         */
+        Automaton(Automaton const& other);
+        Automaton(Automaton&& other);
+        Automaton& operator=(Automaton const& other);
+        Automaton& operator=(Automaton&& other);
+
+        /**
+         *  Seeds the random engine.
+         */
+        template <typename T>
+        void seed(T const& seed)
+        {
+            randGenerator_.seed(seed);
+        }
+
+        /**
+         *  Seeds the random engine with time.
+         */
+        void seed();
+
+        /**
+         *  Returns the random engine, for example to jump ahead or split off streams.
+         */
+        AutomatonRandom& getRandomGenerator();
+
+        /**
+         *  operator<< to insert states into the automata
+         */
+        template <typename T>
+        typename std::enable_if <std::is_same <typename std::decay <T>::type, State>::value, Automaton&>::type
+        operator<<(T&& state)
+        {
+            states_.push_back(std::forward <T&&>(state));
+            insertMappings();
+            return *this;
+        }
+
+        /**
+         *  operator<< to insert id-less states into the automata
+         */
+        template <typename T>
+        typename std::enable_if <std::is_same <typename std::decay <T>::type, ProtoState>::value, Automaton&>::type
+        operator<<(T&& state)
+        {
+            return operator<<(std::move(std::forward <T&&> (state)()));
+        }
+
+        /**
+         *  operator<< to insert states into the automata
+         */
+        Automaton& operator<<(const char* cstr)
+        {
+            return operator<<(ProtoState{cstr}());
+        }
+
+        /**
+         *  operator[] to retrieve state elements by name.
+         */
+        State& operator[](StringView name);
+
+        /**
+         *  operator[] to retrieve state elements by id.
+         */
+        State& operator[](int id);
+
+        /**
+         *  Test for any transition conditions becoming true.
+         */
+        TransitionSet getActiveTransitions();
+
+        /**
+         *  Inserts Transitions.
+         */
+        friend TransitionBegin operator>(Automaton& automat, StringView name);
+
+        /**
+         *  Inserts transitions.
+         */
+        friend TransitionBegin operator>(Automaton& automat, int id);
+
+        /**
+         *  Inserts transitions.
+         */
+        friend TransitionBegin operator>(TransitionBegin const& prior, StringView name);
+
+        /**
+         *  Inserts transitions.
+         */
+        friend TransitionBegin operator>(TransitionBegin const& prior, int id);
+
+        /**
+         *  Inserts transitions.
+         */
+        friend void operator>(TransitionBegin const& prior, ProtoState::StateBinding&& binding);
+
+        /**
+         *  Sets trigger for transition.
+         */
+        friend TransitionBegin operator>(TransitionBegin&& prior, std::function <bool()> const& func);
+
+        /**
+         *  Sets trigger for transition.
+         */
+        friend TransitionBegin operator>(TransitionBegin&& prior, Trigger const& trig);
+
+        /**
+         *  Labels the transition with the input symbols it consumes.
+         */
+        friend TransitionBegin operator>(TransitionBegin&& prior, SymbolSet const& symbols);
+
+        /**
+         *  Sets the priority of the transition.
+         */
+        friend TransitionBegin operator>(TransitionBegin&& prior, Priority priority);
+
+        /**
+         *  Sets the weight of the transition for random selection.
+         *  Throws std::invalid_argument, if the weight is not positive and finite.
+         */
+        friend TransitionBegin operator>(TransitionBegin&& prior, Weight weight);
+
+        /**
+         *  Returns the name of the current state, without copying it.
+         *  The view is valid until states are added.
+         */
+        boost::optional <StringView> getCurrentStateName() const;
+
+        /**
+         *  Returns the index of the current state, 0 for an empty automaton.
+         */
+        std::size_t getCurrentStateIndex() const;
+
+        /**
+         *  Returns the index of the state with the given name, or none.
+         */
+        boost::optional <std::size_t> findState(StringView name) const;
+
+        /**
+         *  Returns the name of the current state
+         */
+        boost::optional <int> getCurrentStateId() const;
+
+        /**
+         *  Moves to the state without calling its action, for example to restore or migrate a session.
+         *  Throws std::invalid_argument, if there is no state with this index.
+         */
+        void setCurrentState(std::size_t index);
+
+        /**
+         *  Returns the amount of bytes checkpoint() writes.
+         */
+        std::size_t checkpointSize() const;
+
+        /**
+         *  Writes the dynamic state (current state, random engine and the hit counts of adaptive ordering)
+         *  into the buffer, which must hold checkpointSize() bytes. States and transitions are not part of it.
+         */
+        void checkpoint(void* buffer) const;
+
+        /**
+         *  Restores the dynamic state written by checkpoint() of an automaton with the same states and transitions.
+         *  Does not call the state action.
+         *  Throws std::invalid_argument, if the checkpoint does not fit this automaton.
+         */
+        void restore(void const* buffer, std::size_t size);
+
+        /**
+         *  Transition to the next state, if possible. Selects a random transition, if multiple are active,
+         *  with probabilities proportional to the transition weights. On a frozen automaton where all
+         *  transitions of the current state are active, this takes constant time using alias tables.
+         *  The choice only depends on the seed, not on the standard library: active transitions of an unfrozen
+         *  automaton are considered in insertion order, those of a frozen one in their frozen order.
+         *
+         *  @return Returns true, if a transition has been made.
+         */
+        bool advance();
+
+        /**
+         *  Feeds one input symbol. Takes one of the transitions labeled with the symbol whose condition
+         *  is true, at random by weight if multiple are. Transitions without symbols are not considered.
+         *
+         *  @return Returns true, if a transition has been made.
+         */
+        bool consume(std::uint8_t symbol);
+
+        /**
+         *  Feeds symbols until one of them cannot be consumed.
+         *
+         *  @return Returns the amount of symbols consumed.
+         */
+        std::size_t consume(std::uint8_t const* data, std::size_t size);
+
+        /**
+         *  Transition to the next state, if possible. Calls the selector function, if multiple are active.
+         *  The selector is called with the set of active transitions and returns an iterator into it.
+         *  The set is reused between steps, so stepping does not allocate once it is warmed up.
+         *
+         *  @return Returns true, if a transition has been made.
+         */
+        template <typename SelectorT>
+        bool advance(SelectorT&& selector)
+        {
+            if (recording_ != nullptr)
+                recordStep(RunRecording::Step::select);
+            return advanceWith(std::forward <SelectorT> (selector));
+        }
+
+        /**
+         *  Takes the first transition whose condition is true, testing them by descending priority
+         *  and in insertion order within a priority. Conditions after the first true one are not evaluated.
+         *  Best used on a frozen automaton, which keeps the transitions in that order.
+         *
+         *  @return Returns true, if a transition has been made.
+         */
+        bool advanceFirstMatch();
+
+        /**
+         *  Lets advanceFirstMatch test transitions of equal priority in order of how often they were taken,
+         *  most frequent first, instead of insertion order. Stepping becomes deterministic only for a given history.
+         */
+        void setAdaptiveOrdering(bool enabled = true);
+
+        /**
+         *  Returns whether adaptive ordering is enabled.
+         */
+        bool isAdaptiveOrdering() const;
+		
+		/**
+		 *	Returns the amout of states.
+		 */
+		std::size_t stateCount() const;
+
+        /**
+         *  Returns true, if advance() cannot make a transition until a signal is notified.
+         *  That is the case when all transitions of the current state are dormant event driven ones.
+         *  Callers can skip stepping this automaton while it is quiescent.
+         */
+        bool isQuiescent() const;
+
+        /**
+         *  Packs all transitions into a contiguous table indexed by state number,
+         *  so that stepping only has to walk one slice of memory.
+         *  Inserting states or transitions afterwards unpacks the table again.
+         */
+        void freeze();
+
+        /**
+         *  Returns whether the transitions are currently packed by freeze().
+         */
+        bool isFrozen() const;
+
+        /**
+         *  Returns the amount of transitions.
+         */
+        std::size_t transitionCount() const;
+
+        /**
+         *  Records transitions, visits, dwell times and guard latencies into the instrumentation,
+         *  which must outlive the automaton or be detached by passing nullptr. Copies share it,
+         *  moves take it along and leave the moved from automaton without one.
+         */
+        void setInstrumentation(Instrumentation* instrumentation);
+
+        /**
+         *  Returns the attached instrumentation or nullptr.
+         */
+        Instrumentation* getInstrumentation() const;
+
+        /**
+         *  Appends every transition taken to the recorder, which must outlive the automaton
+         *  or be detached by passing nullptr. Copies share it, moves take it along and leave
+         *  the moved from automaton without one.
+         *
+         *  @param instance Identifies this automaton in the records.
+         */
+        void setTraceRecorder(TraceRecorder* recorder, std::uint64_t instance = 0);
+
+        /**
+         *  Returns the attached trace recorder or nullptr.
+         */
+        TraceRecorder* getTraceRecorder() const;
+
+        /**
+         *  Starts recording the run into the recording, which is cleared first and must outlive the recording.
+         *  Records the dynamic state, then every step, condition outcome and choice between several transitions.
+         *  Copies of the automaton do not record. Moves take the recording along, the moved from automaton
+         *  stops recording.
+         */
+        void startRecording(RunRecording& recording);
+
+        /**
+         *  Stops recording. The recording is complete afterwards.
+         */
+        void stopRecording();
+
+        /**
+         *  Restores the dynamic state of the recording and repeats its steps, taking conditions and choices
+         *  from the recording instead of calling them. State actions are not called either.
+         *  Stops at the first step that does not end in the recorded state.
+         *  The automaton must have the same states and transitions as the recorded one, frozen or not.
+         *  Throws std::invalid_argument, if the recording does not fit the automaton or is incomplete.
+         */
+        ReplayResult replay(RunRecording const& recording);
+
+    private:
+        void tryEmplace(
+            std::size_t from,
+            std::size_t to,
+            boost::optional <Trigger> const& trig,
+            boost::optional <SymbolSet> const& symbols,
+            int priority,
+            double weight
+        );
+        void insertMappings();
+        void setState(std::size_t num);
+        void recordTransition(Transition const& transition);
+        void recordStep(RunRecording::Step step, std::uint8_t symbol = 0);
+        void recordChoice(Transition const& chosen);
+        bool replayOutcome(Transition const& transition);
+        Transition* replayChoice(TransitionSet const& active);
+
+        template <typename SelectorT>
+        bool advanceWith(SelectorT&& selector)
+        {
+            SharedPredicate::beginEpoch();
+            collectActiveTransitions(active_);
+            if (active_.empty())
+                return false;
+
+            if (active_.size() == 1)
+            {
+                active_.first()->perform();
+                return true;
+            }
+
+            // a replay still calls the selector, so that the random engine advances as in the recorded run.
+            Transition* chosen = *selector(static_cast <TransitionSet const&> (active_));
+            if (recording_ != nullptr)
+                recordChoice(*chosen);
+            else if (replay_ != nullptr)
+                chosen = replayChoice(active_);
+            chosen->perform();
+            return true;
+        }
+
+        bool isObserved() const
+        {
+            return instrumentation_ != nullptr || trace_ != nullptr;
+        }
+        void thaw();
+        void collectActiveTransitions(TransitionSet& result);
+        void collectConsumingTransitions(std::uint8_t symbol, TransitionSet& result);
+        void sortUnfrozen(TransitionSet& transitions) const;
+        TransitionSet::const_iterator selectRandom(TransitionSet const& active);
+        TransitionSet::const_iterator selectWeighted(TransitionSet const& active);
+        void buildAliasTable();
+        bool precedes(Transition const& lhs, Transition const& rhs) const;
+        void sortFrozen();
+        void promote(std::size_t position, std::size_t first);
+
+        template <typename FunctionT>
+        void forEachTransition(std::size_t from, FunctionT&& func)
+        {
+            if (isFrozen())
+            {
+                for (auto i = transitionOffsets_[from]; i != transitionOffsets_[from + 1]; ++i)
+                    func(frozenTransitions_[i]);
+                return;
+            }
+
+            auto range = transitions_.equal_range(from);
+            for (auto i = range.first; i != range.second; ++i)
+                func(i->second);
+        }
+
+        template <typename FunctionT>
+        void forEachTransition(std::size_t from, FunctionT&& func) const
+        {
+            if (isFrozen())
+            {
+                for (auto i = transitionOffsets_[from]; i != transitionOffsets_[from + 1]; ++i)
+                    func(frozenTransitions_[i]);
+                return;
+            }
+
+            auto range = transitions_.equal_range(from);
+            for (auto i = range.first; i != range.second; ++i)
+                func(i->second);
+        }
+        void rebind();
+        void detach();
+        std::size_t getMapped(StringView name);
+        std::size_t getMapped(int id);
+
+    private:
+        // Mappings
+        NameTable nameMappings_;
+        std::unordered_map <int, std::size_t> idMappings_;
+
+        // Can only grow, cannot shrink
+        std::vector <State> states_;
+
+        std::size_t currentState_;
+
+        // Edges / Transitions
+        std::unordered_multimap <std::size_t, Transition> transitions_;
+
+        // Frozen edges in compressed sparse row layout. The outgoing transitions of state i
+        // are frozenTransitions_[transitionOffsets_[i], transitionOffsets_[i + 1]).
+        std::vector <std::size_t> transitionOffsets_;
+        std::vector <Transition> frozenTransitions_;
+
+        // Weights of the transitions without symbols of each frozen state, in slice order.
+        // Stale after adaptive reordering moved transitions, rebuilt on the next random selection.
+        AliasTable aliasTable_;
+        bool aliasStale_;
+
+        // Scratch space for advance, kept to avoid allocations on every step.
+        TransitionSet active_;
+
+        AutomatonRandom randGenerator_;
+        bool adaptive_;
+
+        // Not owned, null unless instrumented. The entry time is only kept while instrumented.
+        Instrumentation* instrumentation_;
+        std::uint64_t enteredAt_;
+
+        // Not owned, null unless recording.
+        TraceRecorder* trace_;
+        std::uint64_t traceInstance_;
+
+        // Positions in the recording being replayed.
+        struct ReplayCursor
+        {
+            RunRecording const* recording;
+            std::size_t step;
+            std::size_t choice;
+            bool diverged;
+        };
+
+        // Not owned, null unless recording or replaying.
+        RunRecording* recording_;
+        ReplayCursor* replay_;
+    };
+
+    Automaton makeAutomaton();
+}
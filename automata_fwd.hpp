@@ -1,7 +1,12 @@
-#pragma once
-
-namespace MiniAutomata
-{
-    class Automaton;
-    class Transition;
-}
+#pragma once
+
+namespace MiniAutomata
+{
+    class Automaton;
+    class AutomatonDefinition;
+    class AutomatonBuilder;
+    class Instrumentation;
+    class TraceRecorder;
+    class RunRecording;
+    class Transition;
+}
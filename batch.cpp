@@ -0,0 +1,200 @@
+#include "batch.hpp"
+#include "predicate.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace MiniAutomata
+{
+//#####################################################################################################################
+    namespace
+    {
+        // Followed by the state of every instance, padded to 8 bytes, and the random state of every instance.
+        struct CheckpointHeader
+        {
+            std::uint64_t stateCount;
+            std::uint64_t edgeCount;
+            std::uint64_t instanceCount;
+        };
+
+        std::size_t statesBytes(std::size_t count)
+        {
+            return (count * sizeof(std::uint32_t) + 7u) & ~std::size_t{7u};
+        }
+    }
+//#####################################################################################################################
+    AutomatonBatch::AutomatonBatch(std::shared_ptr <AutomatonDefinition const> definition)
+        : definition_{std::move(definition)}
+        , states_{}
+        , random_{}
+        , wakeStamps_{}
+    {
+        if (!definition_)
+            throw std::invalid_argument("batch requires a definition");
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void AutomatonBatch::reserve(std::size_t count)
+    {
+        states_.reserve(count);
+        random_.reserve(count);
+        wakeStamps_.reserve(count);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t AutomatonBatch::add(std::uint64_t seed, std::size_t start)
+    {
+        auto instance = definition_->makeInstance(seed, start);
+        states_.push_back(instance.state);
+        random_.push_back(instance.random);
+        wakeStamps_.push_back(0);
+        return states_.size() - 1;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t AutomatonBatch::size() const
+    {
+        return states_.size();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint32_t const* AutomatonBatch::states() const
+    {
+        return states_.data();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    AutomatonInstance AutomatonBatch::getInstance(std::size_t index) const
+    {
+        return {states_[index], random_[index]};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void AutomatonBatch::setInstance(std::size_t index, AutomatonInstance const& instance)
+    {
+        states_[index] = instance.state;
+        random_[index] = instance.random;
+        wakeStamps_[index] = 0;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    AutomatonDefinition const& AutomatonBatch::getDefinition() const
+    {
+        return *definition_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t AutomatonBatch::checkpointSize() const
+    {
+        return sizeof(CheckpointHeader) + statesBytes(states_.size()) + random_.size() * sizeof(std::uint64_t);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void AutomatonBatch::checkpoint(void* buffer) const
+    {
+        auto* out = static_cast <char*> (buffer);
+        CheckpointHeader header{definition_->stateCount(), definition_->edgeCount(), states_.size()};
+        std::memcpy(out, &header, sizeof(header));
+        out += sizeof(header);
+
+        auto stateBytes = states_.size() * sizeof(std::uint32_t);
+        if (!states_.empty())
+            std::memcpy(out, states_.data(), stateBytes);
+        std::memset(out + stateBytes, 0, statesBytes(states_.size()) - stateBytes);
+        out += statesBytes(states_.size());
+
+        if (!random_.empty())
+            std::memcpy(out, random_.data(), random_.size() * sizeof(std::uint64_t));
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void AutomatonBatch::restore(void const* buffer, std::size_t size)
+    {
+        auto const* in = static_cast <char const*> (buffer);
+        CheckpointHeader header;
+        if (size < sizeof(header))
+            throw std::invalid_argument("checkpoint is truncated");
+        std::memcpy(&header, in, sizeof(header));
+        in += sizeof(header);
+
+        if (header.stateCount != definition_->stateCount() || header.edgeCount != definition_->edgeCount())
+            throw std::invalid_argument("checkpoint was taken from a batch of a different definition");
+        if (header.instanceCount > (size - sizeof(header)) / (sizeof(std::uint32_t) + sizeof(std::uint64_t)) ||
+            size != sizeof(header) + statesBytes(header.instanceCount) + header.instanceCount * sizeof(std::uint64_t))
+        {
+            throw std::invalid_argument("checkpoint is truncated");
+        }
+
+        auto count = static_cast <std::size_t> (header.instanceCount);
+        std::vector <std::uint32_t> states(count);
+        if (count != 0)
+            std::memcpy(states.data(), in, count * sizeof(std::uint32_t));
+        auto stateCount = definition_->stateCount();
+        if (std::any_of(std::begin(states), std::end(states), [stateCount](std::uint32_t state) {return state >= stateCount;}))
+            throw std::invalid_argument("checkpoint contains an instance in a state the definition does not have");
+        in += statesBytes(count);
+
+        std::vector <std::uint64_t> random(count);
+        if (count != 0)
+            std::memcpy(random.data(), in, count * sizeof(std::uint64_t));
+
+        std::vector <std::uint64_t> wakeStamps(count, 0);
+        states_ = std::move(states);
+        random_ = std::move(random);
+        wakeStamps_ = std::move(wakeStamps);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t AutomatonBatch::advance()
+    {
+        return advance(0, states_.size());
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t AutomatonBatch::advance(std::size_t first, std::size_t last)
+    {
+        constexpr std::size_t blockSize = 256;
+
+        auto const* forced = definition_->forcedSuccessors();
+        auto* states = states_.data();
+        std::array <std::uint32_t, blockSize> next;
+        std::size_t moved = 0;
+
+        // shared predicates are evaluated at most once for the whole range.
+        SharedPredicate::beginEpoch();
+
+        for (auto block = first; block < last; block += blockSize)
+        {
+            auto count = std::min(blockSize, last - block);
+
+            // Branch free gather over the successor table, the compiler can vectorize this.
+            for (std::size_t i = 0; i != count; ++i)
+                next[i] = forced[states[block + i]];
+
+            for (std::size_t i = 0; i != count; ++i)
+            {
+                if (next[i] < AutomatonDefinition::deadEnd)
+                {
+                    states[block + i] = next[i];
+                    ++moved;
+                }
+                else if (next[i] == AutomatonDefinition::generalPath)
+                {
+                    auto state = states[block + i];
+                    auto& wakeStamp = wakeStamps_[block + i];
+                    bool eventDriven = definition_->isEventDriven(state);
+                    std::uint64_t stamp = 0;
+                    if (eventDriven)
+                    {
+                        stamp = definition_->dependencyStamp(state);
+                        if (wakeStamp == stamp + 1)
+                            continue;
+                    }
+
+                    AutomatonInstance instance{state, random_[block + i]};
+                    if (definition_->advance(instance))
+                    {
+                        ++moved;
+                        wakeStamp = 0;
+                    }
+                    else if (eventDriven)
+                        wakeStamp = stamp + 1;
+                    states[block + i] = instance.state;
+                    random_[block + i] = instance.random;
+                }
+            }
+        }
+        return moved;
+    }
+//#####################################################################################################################
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "definition.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace MiniAutomata
+{
+    /**
+     *  Many instances of one definition in structure of arrays layout.
+     *  The current states of all instances are stored in one contiguous array,
+     *  the random generator states in another.
+     */
+    class AutomatonBatch
+    {
+    public:
+        explicit AutomatonBatch(std::shared_ptr <AutomatonDefinition const> definition);
+
+        /**
+         *  Reserves space for the given amount of instances.
+         */
+        void reserve(std::size_t count);
+
+        /**
+         *  Adds an instance sitting at the given state. Does not call the state action.
+         *
+         *  @return Returns the index of the new instance.
+         */
+        std::size_t add(std::uint64_t seed, std::size_t start = 0);
+
+        /**
+         *  Returns the amount of instances.
+         */
+        std::size_t size() const;
+
+        /**
+         *  Returns the current state indices of all instances.
+         */
+        std::uint32_t const* states() const;
+
+        /**
+         *  Returns a copy of the instance at the given index.
+         */
+        AutomatonInstance getInstance(std::size_t index) const;
+
+        /**
+         *  Overwrites the instance at the given index. Does not call the state action.
+         */
+        void setInstance(std::size_t index, AutomatonInstance const& instance);
+
+        /**
+         *  Returns the shared definition.
+         */
+        AutomatonDefinition const& getDefinition() const;
+
+        /**
+         *  Returns the amount of bytes checkpoint() writes.
+         */
+        std::size_t checkpointSize() const;
+
+        /**
+         *  Writes the current states and random generator states of all instances into the buffer,
+         *  which must hold checkpointSize() bytes. Each is one contiguous block, the definition is not part of it.
+         */
+        void checkpoint(void* buffer) const;
+
+        /**
+         *  Replaces all instances by those of a checkpoint taken from a batch of the same definition.
+         *  Does not call state actions. Every instance is awake afterwards.
+         *  Throws std::invalid_argument, if the checkpoint does not fit the definition.
+         */
+        void restore(void const* buffer, std::size_t size);
+
+        /**
+         *  Advances every instance by one step, selecting random transitions where multiple are active.
+         *  Instances sitting in event driven states whose signals did not change since they last found
+         *  no active transition are skipped without evaluating any condition.
+         *
+         *  @return Returns the amount of instances that made a transition.
+         */
+        std::size_t advance();
+
+        /**
+         *  Advances the instances [first, last) by one step.
+         *  Disjoint ranges may be advanced from different threads at the same time.
+         *  Shared predicates are evaluated at most once per call and thread.
+         *
+         *  @return Returns the amount of instances that made a transition.
+         */
+        std::size_t advance(std::size_t first, std::size_t last);
+
+    private:
+        std::shared_ptr <AutomatonDefinition const> definition_;
+
+        std::vector <std::uint32_t> states_;
+        std::vector <std::uint64_t> random_;
+
+        // Instances sleeping in an event driven state store the dependency stamp + 1, awake ones 0.
+        std::vector <std::uint64_t> wakeStamps_;
+    };
+}
@@ -0,0 +1,234 @@
+#include "../automata.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+ *  Measures the costs of building and stepping automata over a range of graph sizes and fan-outs.
+ *  Prints one result per line, as CSV (default) or as JSON lines (--json).
+ *
+ *  usage: automata_bench [--json] [--states 16,256,4096] [--fanout 2,8,32] [--min-time 200]
+ */
+
+namespace
+{
+    using namespace MiniAutomata;
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        bool json = false;
+        std::vector <std::size_t> states = {16, 256, 4096, 65536};
+        std::vector <std::size_t> fanouts = {2, 8, 32};
+        std::chrono::milliseconds minTime{200};
+    };
+
+    struct Result
+    {
+        char const* benchmark;
+        std::size_t states;
+        std::size_t fanout;
+        std::uint64_t iterations;
+        double nanosPerOp;
+    };
+
+    // keeps results alive, so the measured work is not optimized away.
+    volatile std::uintptr_t sink;
+
+    std::vector <std::size_t> parseList(char const* text)
+    {
+        std::vector <std::size_t> result;
+        for (char const* begin = text; *begin != '\0';)
+        {
+            char* end;
+            result.push_back(std::strtoull(begin, &end, 10));
+            if (end == begin)
+                break;
+            begin = *end == ',' ? end + 1 : end;
+        }
+        return result;
+    }
+
+    Options parseOptions(int argc, char** argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; ++i)
+        {
+            if (std::strcmp(argv[i], "--json") == 0)
+                options.json = true;
+            else if (std::strcmp(argv[i], "--states") == 0 && i + 1 < argc)
+                options.states = parseList(argv[++i]);
+            else if (std::strcmp(argv[i], "--fanout") == 0 && i + 1 < argc)
+                options.fanouts = parseList(argv[++i]);
+            else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+                options.minTime = std::chrono::milliseconds{std::strtoull(argv[++i], nullptr, 10)};
+            else
+            {
+                std::cerr << "usage: " << argv[0] << " [--json] [--states 16,256,4096] [--fanout 2,8,32] [--min-time ms]\n";
+                std::exit(1);
+            }
+        }
+        return options;
+    }
+
+    void print(Options const& options, Result const& result)
+    {
+        if (options.json)
+        {
+            std::cout
+                << "{\"benchmark\":\"" << result.benchmark << "\""
+                << ",\"states\":" << result.states
+                << ",\"fanout\":" << result.fanout
+                << ",\"iterations\":" << result.iterations
+                << ",\"ns_per_op\":" << result.nanosPerOp
+                << "}\n"
+            ;
+        }
+        else
+        {
+            std::cout
+                << result.benchmark << ","
+                << result.states << ","
+                << result.fanout << ","
+                << result.iterations << ","
+                << result.nanosPerOp << "\n"
+            ;
+        }
+    }
+
+    /**
+     *  Runs func(iterations) with growing iteration counts until one run takes at least the minimum time.
+     *  Returns the iterations and nanoseconds per iteration of that run.
+     */
+    template <typename FunctionT>
+    std::pair <std::uint64_t, double> measure(Options const& options, FunctionT&& func)
+    {
+        for (std::uint64_t iterations = 1;; iterations *= 2)
+        {
+            auto start = Clock::now();
+            func(iterations);
+            auto elapsed = Clock::now() - start;
+            if (elapsed >= options.minTime || iterations >= (std::uint64_t{1} << 40))
+            {
+                auto nanos = std::chrono::duration_cast <std::chrono::nanoseconds> (elapsed).count();
+                return {iterations, static_cast <double> (nanos) / static_cast <double> (iterations)};
+            }
+        }
+    }
+
+    // every state gets fanout transitions with always true guards to pseudo random targets.
+    Automaton buildGraph(std::size_t stateCount, std::size_t fanout, std::vector <std::string> const& names)
+    {
+        auto automat = makeAutomaton();
+        for (std::size_t i = 0; i != stateCount; ++i)
+            automat << State{static_cast <int> (i), std::string{names[i]}};
+
+        std::uint64_t seed = 0x9E3779B97F4A7C15ull;
+        for (std::size_t i = 0; i != stateCount; ++i)
+        {
+            for (std::size_t j = 0; j != fanout; ++j)
+            {
+                seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+                auto target = static_cast <int> ((seed >> 33) % stateCount);
+                automat > static_cast <int> (i) > [](){return true;} > target;
+            }
+        }
+        return automat;
+    }
+
+    void runGraph(Options const& options, std::size_t stateCount, std::size_t fanout)
+    {
+        std::vector <std::string> names;
+        names.reserve(stateCount);
+        for (std::size_t i = 0; i != stateCount; ++i)
+            names.push_back("state " + std::to_string(i));
+
+        auto report = [&](char const* benchmark, std::pair <std::uint64_t, double> measured) {
+            print(options, Result{benchmark, stateCount, fanout, measured.first, measured.second});
+        };
+
+        // construction is reported per transition.
+        {
+            auto measured = measure(options, [&](std::uint64_t iterations) {
+                for (std::uint64_t i = 0; i != iterations; ++i)
+                    sink = buildGraph(stateCount, fanout, names).transitionCount();
+            });
+            measured.second /= static_cast <double> (stateCount * fanout);
+            report("construct", measured);
+        }
+
+        auto automat = buildGraph(stateCount, fanout, names);
+
+        report("lookup_name", measure(options, [&](std::uint64_t iterations) {
+            std::size_t state = 0;
+            for (std::uint64_t i = 0; i != iterations; ++i)
+            {
+                sink = reinterpret_cast <std::uintptr_t> (&automat[names[state]]);
+                if (++state == stateCount)
+                    state = 0;
+            }
+        }));
+
+        report("lookup_id", measure(options, [&](std::uint64_t iterations) {
+            int state = 0;
+            for (std::uint64_t i = 0; i != iterations; ++i)
+            {
+                sink = reinterpret_cast <std::uintptr_t> (&automat[state]);
+                if (++state == static_cast <int> (stateCount))
+                    state = 0;
+            }
+        }));
+
+        report("active_transitions", measure(options, [&](std::uint64_t iterations) {
+            std::size_t state = 0;
+            for (std::uint64_t i = 0; i != iterations; ++i)
+            {
+                automat.setCurrentState(state);
+                sink = automat.getActiveTransitions().size();
+                if (++state == stateCount)
+                    state = 0;
+            }
+        }));
+
+        report("advance_random", measure(options, [&](std::uint64_t iterations) {
+            for (std::uint64_t i = 0; i != iterations; ++i)
+                sink = automat.advance();
+        }));
+
+        report("advance_selector", measure(options, [&](std::uint64_t iterations) {
+            std::size_t turn = 0;
+            auto selector = [&turn](TransitionSet const& active) {
+                return std::begin(active) + (turn++ % active.size());
+            };
+            for (std::uint64_t i = 0; i != iterations; ++i)
+                sink = automat.advance(selector);
+        }));
+
+        automat.freeze();
+
+        report("advance_random_frozen", measure(options, [&](std::uint64_t iterations) {
+            for (std::uint64_t i = 0; i != iterations; ++i)
+                sink = automat.advance();
+        }));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    auto options = parseOptions(argc, argv);
+
+    if (!options.json)
+        std::cout << "benchmark,states,fanout,iterations,ns_per_op\n";
+
+    for (auto stateCount : options.states)
+        for (auto fanout : options.fanouts)
+            if (stateCount != 0 && fanout != 0)
+                runGraph(options, stateCount, fanout);
+
+    return 0;
+}
@@ -0,0 +1,242 @@
+#include "builder.hpp"
+#include "automata.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+namespace MiniAutomata
+{
+	using namespace std::string_literals;
+//#####################################################################################################################
+    namespace
+    {
+        struct EdgeKey
+        {
+            std::size_t from;
+            std::size_t to;
+
+            // 0 for unlabeled, 1 for symbols and 2 for epsilon edges. Only edges with the same label kind are merged.
+            int label;
+            std::size_t edge;
+
+            bool operator<(EdgeKey const& other) const
+            {
+                return std::tie(from, to, label, edge) < std::tie(other.from, other.to, other.label, other.edge);
+            }
+
+            bool sameTarget(EdgeKey const& other) const
+            {
+                return from == other.from && to == other.to && label == other.label;
+            }
+        };
+    }
+//#####################################################################################################################
+    constexpr std::size_t AutomatonBuilder::none;
+//#####################################################################################################################
+    AutomatonBuilder::AutomatonBuilder()
+        : nameMappings_{}
+        , idMappings_{}
+        , states_{}
+        , edges_{}
+        , triggers_{}
+        , symbols_{}
+    {
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void AutomatonBuilder::reserve(std::size_t states, std::size_t edges)
+    {
+        nameMappings_.reserve(states);
+        states_.reserve(states);
+        edges_.reserve(edges);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t AutomatonBuilder::addState(State state)
+    {
+        auto index = states_.size();
+        state.intern(nameMappings_, index);
+        auto id = state.getId();
+        if (id)
+            idMappings_.emplace(id.get(), index);
+        states_.push_back(std::move(state));
+        return index;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t AutomatonBuilder::addState(std::string name)
+    {
+        return addState(State{std::move(name)});
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void AutomatonBuilder::addEdge(
+        std::size_t from,
+        std::size_t to,
+        boost::optional <Trigger> const& trig,
+        boost::optional <SymbolSet> const& symbols,
+        int priority,
+        double weight
+    )
+    {
+        if (!(weight > 0.) || !std::isfinite(weight))
+            throw std::invalid_argument("transition weight must be positive and finite");
+
+        Edge edge{from, to, none, none, priority, weight};
+        if (trig)
+        {
+            edge.trig = triggers_.size();
+            triggers_.push_back(trig.get());
+        }
+        if (symbols)
+        {
+            edge.symbols = symbols_.size();
+            symbols_.push_back(symbols.get());
+        }
+        edges_.push_back(edge);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void AutomatonBuilder::addEdge(
+        StringView from,
+        StringView to,
+        boost::optional <Trigger> const& trig,
+        boost::optional <SymbolSet> const& symbols,
+        int priority,
+        double weight
+    )
+    {
+        auto fromIndex = nameMappings_.find(from);
+        if (!fromIndex)
+            throw std::invalid_argument(("no such state with name '"s + from.to_string() + "' in builder").c_str());
+        auto toIndex = nameMappings_.find(to);
+        if (!toIndex)
+            throw std::invalid_argument(("no such state with name '"s + to.to_string() + "' in builder").c_str());
+        addEdge(fromIndex.get(), toIndex.get(), trig, symbols, priority, weight);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    boost::optional <std::size_t> AutomatonBuilder::findState(StringView name) const
+    {
+        return nameMappings_.find(name);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t AutomatonBuilder::stateCount() const
+    {
+        return states_.size();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t AutomatonBuilder::edgeCount() const
+    {
+        return edges_.size();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Automaton AutomatonBuilder::build()
+    {
+        auto stateCount = states_.size();
+
+        // sort small keys instead of the edges, equal targets end up next to each other in insertion order.
+        std::vector <EdgeKey> keys;
+        keys.reserve(edges_.size());
+        for (std::size_t i = 0; i != edges_.size(); ++i)
+        {
+            auto const& edge = edges_[i];
+            if (edge.from >= stateCount || edge.to >= stateCount)
+            {
+                throw std::invalid_argument((
+                    "transition from state "s + std::to_string(edge.from) + " to state " + std::to_string(edge.to) +
+                    " refers to a state that was not added to the builder"
+                ).c_str());
+            }
+            int label = 0;
+            if (edge.symbols != none)
+                label = symbols_[edge.symbols].isEpsilon() ? 2 : 1;
+            keys.push_back(EdgeKey{edge.from, edge.to, label, i});
+        }
+        std::sort(std::begin(keys), std::end(keys));
+
+        // keep the first edge of every run. Labeled duplicates are merged into the first kept edge they only differ
+        // from in their symbols, like Automaton does, or kept themselves if there is none.
+        auto mergeable = [this](Edge const& lhs, Edge const& rhs) {
+            auto unconditional = [this](Edge const& edge) {
+                return edge.trig == none || triggers_[edge.trig].isUnconditional();
+            };
+            return unconditional(lhs) && unconditional(rhs) && lhs.priority == rhs.priority && lhs.weight == rhs.weight;
+        };
+        std::vector <char> kept(edges_.size(), 0);
+        for (std::size_t i = 0; i != keys.size();)
+        {
+            kept[keys[i].edge] = 1;
+            std::size_t j = i + 1;
+            for (; j != keys.size() && keys[j].sameTarget(keys[i]); ++j)
+            {
+                auto const& duplicate = edges_[keys[j].edge];
+                if (duplicate.symbols == none)
+                    continue;
+
+                std::size_t k = i;
+                for (; k != j; ++k)
+                    if (kept[keys[k].edge] && mergeable(edges_[keys[k].edge], duplicate))
+                        break;
+                if (k == j)
+                    kept[keys[j].edge] = 1;
+                else
+                    symbols_[edges_[keys[k].edge].symbols].add(symbols_[duplicate.symbols]);
+            }
+            i = j;
+        }
+
+        // counting sort the kept edges by source state, stable in insertion order.
+        std::vector <std::size_t> offsets(stateCount + 1, 0);
+        for (std::size_t i = 0; i != edges_.size(); ++i)
+            if (kept[i])
+                ++offsets[edges_[i].from + 1];
+        for (std::size_t from = 0; from != stateCount; ++from)
+            offsets[from + 1] += offsets[from];
+
+        std::vector <std::size_t> order(offsets[stateCount]);
+        {
+            auto cursor = offsets;
+            for (std::size_t i = 0; i != edges_.size(); ++i)
+                if (kept[i])
+                    order[cursor[edges_[i].from]++] = i;
+        }
+
+        Automaton automaton;
+        automaton.frozenTransitions_.reserve(order.size());
+        for (auto i : order)
+        {
+            auto const& edge = edges_[i];
+            Transition transition{
+                &automaton,
+                edge.to,
+                edge.trig == none ? boost::optional <Trigger> {} : std::move(triggers_[edge.trig]),
+                edge.symbols == none ? boost::optional <SymbolSet> {} : symbols_[edge.symbols]
+            };
+            transition.priority_ = edge.priority;
+            transition.weight_ = edge.weight;
+            automaton.frozenTransitions_.push_back(std::move(transition));
+        }
+
+        // number the transitions like operator> would have, in insertion order without duplicates.
+        {
+            std::size_t sequence = 0;
+            auto cursor = offsets;
+            for (std::size_t i = 0; i != edges_.size(); ++i)
+                if (kept[i])
+                    automaton.frozenTransitions_[cursor[edges_[i].from]++].sequence_ = sequence++;
+        }
+
+        automaton.nameMappings_ = std::move(nameMappings_);
+        automaton.idMappings_ = std::move(idMappings_);
+        automaton.states_ = std::move(states_);
+        automaton.transitionOffsets_ = std::move(offsets);
+        automaton.sortFrozen();
+
+        nameMappings_ = NameTable{};
+        idMappings_.clear();
+        states_.clear();
+        edges_.clear();
+        triggers_.clear();
+        symbols_.clear();
+        return automaton;
+    }
+//#####################################################################################################################
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "automata_fwd.hpp"
+#include "state.hpp"
+#include "trigger.hpp"
+#include "symbols.hpp"
+#include "names.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+namespace MiniAutomata
+{
+    /**
+     *  Collects states and transitions of a large automaton and builds it in one pass.
+     *  Inserting through operator< and operator> looks for duplicates on every transition,
+     *  which is quadratic in the fan-out of a state. The builder only appends, and removes
+     *  duplicates once by sorting, so building takes O(n log n) in the amount of transitions.
+     *  Duplicates are merged the same way as by operator>: the first transition to a target wins,
+     *  labeled transitions to the same target have their symbols joined.
+     */
+    class AutomatonBuilder
+    {
+    public:
+        AutomatonBuilder();
+
+        /**
+         *  Reserves memory for the given amount of states and transitions.
+         */
+        void reserve(std::size_t states, std::size_t edges);
+
+        /**
+         *  Adds a state. A name that is already taken is kept by the first state, as with operator<<.
+         *
+         *  @return Returns the index of the new state.
+         */
+        std::size_t addState(State state);
+
+        /**
+         *  Adds a state without id.
+         *
+         *  @return Returns the index of the new state.
+         */
+        std::size_t addState(std::string name);
+
+        /**
+         *  Adds a transition between state indices. The states do not need to be added yet,
+         *  build() checks that they exist.
+         *  Throws std::invalid_argument, if the weight is not positive and finite.
+         */
+        void addEdge(
+            std::size_t from,
+            std::size_t to,
+            boost::optional <Trigger> const& trig = boost::none,
+            boost::optional <SymbolSet> const& symbols = boost::none,
+            int priority = 0,
+            double weight = 1.
+        );
+
+        /**
+         *  Adds a transition between named states.
+         *  Throws std::invalid_argument, if a state is unknown or the weight is not positive and finite.
+         */
+        void addEdge(
+            StringView from,
+            StringView to,
+            boost::optional <Trigger> const& trig = boost::none,
+            boost::optional <SymbolSet> const& symbols = boost::none,
+            int priority = 0,
+            double weight = 1.
+        );
+
+        /**
+         *  Returns the index of the state with the given name, or none.
+         */
+        boost::optional <std::size_t> findState(StringView name) const;
+
+        /**
+         *  Returns the amount of states added.
+         */
+        std::size_t stateCount() const;
+
+        /**
+         *  Returns the amount of transitions added, including duplicates.
+         */
+        std::size_t edgeCount() const;
+
+        /**
+         *  Builds a frozen automaton sitting at the first state and leaves the builder empty.
+         *  Throws std::invalid_argument, if a transition refers to a state that was not added.
+         */
+        Automaton build();
+
+    private:
+        // Triggers and symbols are rare in generated graphs, so they are kept out of line
+        // and the edges stay small to sort.
+        struct Edge
+        {
+            std::size_t from;
+            std::size_t to;
+            std::size_t trig;
+            std::size_t symbols;
+            int priority;
+            double weight;
+        };
+
+        constexpr static std::size_t none = static_cast <std::size_t> (-1);
+
+    private:
+        NameTable nameMappings_;
+        std::unordered_map <int, std::size_t> idMappings_;
+        std::vector <State> states_;
+        std::vector <Edge> edges_;
+        std::vector <Trigger> triggers_;
+        std::vector <SymbolSet> symbols_;
+    };
+}
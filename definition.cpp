@@ -0,0 +1,265 @@
+#include "definition.hpp"
+#include "automata.hpp"
+#include "random.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace MiniAutomata
+{
+	using namespace std::string_literals;
+//#####################################################################################################################
+    constexpr std::uint32_t AutomatonDefinition::generalPath;
+//#####################################################################################################################
+    AutomatonDefinition::AutomatonDefinition(Automaton const& automaton)
+        : nameMappings_{automaton.nameMappings_}
+        , idMappings_{automaton.idMappings_}
+        , states_{State::copyInterned(automaton.states_, nameMappings_)}
+        , edgeOffsets_(automaton.states_.size() + 1, 0)
+        , edges_{}
+        , forcedSuccessors_(automaton.states_.size(), generalPath)
+        , eventDriven_(automaton.states_.size(), false)
+        , unguarded_(automaton.states_.size(), false)
+        , aliasEdges_{}
+        , aliasTable_{}
+    {
+        auto addEdge = [this](Transition const& transition) {
+            edges_.push_back(Edge{transition.getTarget(), transition.getTrigger(), transition.getSymbols(), transition.getWeight()});
+        };
+
+        if (automaton.isFrozen())
+            edges_.reserve(automaton.frozenTransitions_.size());
+        else
+            edges_.reserve(automaton.transitions_.size());
+
+        std::vector <Transition const*> unfrozen;
+        for (std::size_t from = 0; from != states_.size(); ++from)
+        {
+            edgeOffsets_[from] = edges_.size();
+            if (automaton.isFrozen())
+            {
+                for (auto i = automaton.transitionOffsets_[from]; i != automaton.transitionOffsets_[from + 1]; ++i)
+                    addEdge(automaton.frozenTransitions_[i]);
+            }
+            else
+            {
+                // the order of the multimap depends on the standard library, insertion order does not.
+                unfrozen.clear();
+                auto range = automaton.transitions_.equal_range(from);
+                for (auto i = range.first; i != range.second; ++i)
+                    unfrozen.push_back(&i->second);
+                std::sort(std::begin(unfrozen), std::end(unfrozen), [](Transition const* lhs, Transition const* rhs) {
+                    return lhs->getSequence() < rhs->getSequence();
+                });
+                for (auto const* transition : unfrozen)
+                    addEdge(*transition);
+            }
+        }
+        edgeOffsets_[states_.size()] = edges_.size();
+
+        for (std::size_t state = 0; state != states_.size(); ++state)
+        {
+            // symbol labeled edges are never taken by advance.
+            std::size_t count = 0;
+            Edge const* single = nullptr;
+            for (auto i = edgesBegin(state); i != edgesEnd(state); ++i)
+            {
+                if (!i->symbols)
+                {
+                    ++count;
+                    single = i;
+                }
+            }
+
+            if (count == 0)
+                forcedSuccessors_[state] = deadEnd;
+            else if (count == 1 && single->trigger.isUnconditional() && !states_[single->to].hasAction())
+                forcedSuccessors_[state] = static_cast <std::uint32_t> (single->to);
+
+            eventDriven_[state] = std::all_of(edgesBegin(state), edgesEnd(state), [](Edge const& edge) {
+                return edge.symbols || (!edge.trigger.isUnconditional() && edge.trigger.isEventDriven());
+            });
+        }
+
+        std::vector <std::size_t> aliasOffsets(1, 0);
+        std::vector <double> weights;
+        for (std::size_t state = 0; state != states_.size(); ++state)
+        {
+            unguarded_[state] = std::all_of(edgesBegin(state), edgesEnd(state), [](Edge const& edge) {
+                return edge.symbols || edge.trigger.isUnconditional();
+            });
+            if (unguarded_[state])
+            {
+                for (auto i = edgesBegin(state); i != edgesEnd(state); ++i)
+                {
+                    if (i->symbols)
+                        continue;
+                    aliasEdges_.push_back(static_cast <std::uint32_t> (i - edges_.data()));
+                    weights.push_back(i->weight);
+                }
+            }
+            aliasOffsets.push_back(weights.size());
+        }
+        aliasTable_ = AliasTable{aliasOffsets, weights};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    AutomatonInstance AutomatonDefinition::makeInstance(std::uint64_t seed, std::size_t start) const
+    {
+        if (start >= states_.size())
+            throw std::invalid_argument(("no such state with index '"s + std::to_string(start) + "' in definition").c_str());
+        return {static_cast <std::uint32_t> (start), seed};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t AutomatonDefinition::getIndex(StringView name) const
+    {
+        auto index = nameMappings_.find(name);
+        if (index)
+            return index.get();
+        else
+            throw std::invalid_argument(("no such state with name '"s + name.to_string() + "' in definition").c_str());
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t AutomatonDefinition::getIndex(int id) const
+    {
+        auto iter = idMappings_.find(id);
+        if (iter != std::end(idMappings_))
+            return iter->second;
+        else
+            throw std::invalid_argument(("no such state with id '"s + std::to_string(id) + "' in definition").c_str());
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    State const& AutomatonDefinition::getState(std::size_t index) const
+    {
+        return states_[index];
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    State const& AutomatonDefinition::getCurrentState(AutomatonInstance const& instance) const
+    {
+        return states_[instance.state];
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t AutomatonDefinition::stateCount() const
+    {
+        return states_.size();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t AutomatonDefinition::edgeCount() const
+    {
+        return edges_.size();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    AutomatonDefinition::Edge const* AutomatonDefinition::edgesBegin(std::size_t state) const
+    {
+        return edges_.data() + edgeOffsets_[state];
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    AutomatonDefinition::Edge const* AutomatonDefinition::edgesEnd(std::size_t state) const
+    {
+        return edges_.data() + edgeOffsets_[state + 1];
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint32_t const* AutomatonDefinition::forcedSuccessors() const
+    {
+        return forcedSuccessors_.data();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool AutomatonDefinition::isEventDriven(std::size_t state) const
+    {
+        return eventDriven_[state];
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint64_t AutomatonDefinition::dependencyStamp(std::size_t state) const
+    {
+        std::uint64_t stamp = 0;
+        auto end = edgesEnd(state);
+        for (auto i = edgesBegin(state); i != end; ++i)
+            stamp += i->trigger.dependencyStamp();
+        return stamp;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void AutomatonDefinition::getActiveEdges(AutomatonInstance const& instance, EdgeSet& result) const
+    {
+        result.clear();
+        auto end = edgesEnd(instance.state);
+        for (auto i = edgesBegin(instance.state); i != end; ++i)
+        {
+            if (!i->symbols && i->trigger.test())
+                result.insert(i);
+        }
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void AutomatonDefinition::perform(AutomatonInstance& instance, Edge const& edge) const
+    {
+        instance.state = static_cast <std::uint32_t> (edge.to);
+        states_[edge.to]();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool AutomatonDefinition::consume(AutomatonInstance& instance, std::uint8_t symbol) const
+    {
+        // weighted reservoir sampling over the active edges.
+        SplitMix64 generator{instance.random};
+        Edge const* chosen = nullptr;
+        double total = 0.;
+
+        auto end = edgesEnd(instance.state);
+        for (auto i = edgesBegin(instance.state); i != end; ++i)
+        {
+            if (!i->symbols || !i->symbols->contains(symbol) || !i->trigger.test())
+                continue;
+
+            total += i->weight;
+            if (chosen == nullptr || randomUnit(generator) * total < i->weight)
+                chosen = i;
+        }
+
+        if (chosen == nullptr)
+            return false;
+
+        perform(instance, *chosen);
+        return true;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool AutomatonDefinition::advance(AutomatonInstance& instance) const
+    {
+        SplitMix64 generator{instance.random};
+        if (unguarded_[instance.state])
+        {
+            // every edge is active, so the alias table of the state applies.
+            auto count = aliasTable_.rowSize(instance.state);
+            if (count == 0)
+                return false;
+
+            auto offset = aliasTable_.rowOffset(instance.state);
+            auto position = count == 1 ? 0 : aliasTable_.sample(instance.state, generator);
+            perform(instance, edges_[aliasEdges_[offset + position]]);
+            return true;
+        }
+
+        // weighted reservoir sampling over the active edges, so no set has to be built.
+        Edge const* chosen = nullptr;
+        double total = 0.;
+
+        auto end = edgesEnd(instance.state);
+        for (auto i = edgesBegin(instance.state); i != end; ++i)
+        {
+            if (i->symbols || !i->trigger.test())
+                continue;
+
+            total += i->weight;
+            if (chosen == nullptr || randomUnit(generator) * total < i->weight)
+                chosen = i;
+        }
+
+        if (chosen == nullptr)
+            return false;
+
+        perform(instance, *chosen);
+        return true;
+    }
+//#####################################################################################################################
+    std::shared_ptr <AutomatonDefinition const> makeDefinition(Automaton const& automaton)
+    {
+        return std::make_shared <AutomatonDefinition const> (automaton);
+    }
+//#####################################################################################################################
+}
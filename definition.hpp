@@ -0,0 +1,197 @@
+#pragma once
+
+#include "automata_fwd.hpp"
+#include "state.hpp"
+#include "trigger.hpp"
+#include "pointer_set.hpp"
+#include "symbols.hpp"
+#include "alias_table.hpp"
+#include "names.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MiniAutomata
+{
+    /**
+     *  The per-instance part of an automaton. Holds nothing but the current state index
+     *  and the random generator state, everything else is shared in an AutomatonDefinition.
+     */
+    struct AutomatonInstance
+    {
+        std::uint32_t state;
+        std::uint64_t random;
+    };
+
+    /**
+     *  An immutable automaton topology (states, actions and transitions) that is built once
+     *  from an Automaton and then drives any number of AutomatonInstance objects.
+     *  Transitions are stored in compressed sparse row layout indexed by state.
+     */
+    class AutomatonDefinition
+    {
+    public:
+        struct Edge
+        {
+            std::size_t to;
+            Trigger trigger;
+            boost::optional <SymbolSet> symbols;
+            double weight;
+        };
+
+        using EdgeSet = PointerSet <Edge const>;
+
+        constexpr static std::uint32_t generalPath = 0xFFFFFFFFu;
+        constexpr static std::uint32_t deadEnd = 0xFFFFFFFEu;
+
+    public:
+        /**
+         *  Copies states and transitions out of the automaton. The edges of a state keep the order of a frozen
+         *  automaton, or the insertion order of an unfrozen one.
+         */
+        explicit AutomatonDefinition(Automaton const& automaton);
+
+        /**
+         *  Creates a new instance sitting at the given state. Does not call the state action.
+         */
+        AutomatonInstance makeInstance(std::uint64_t seed, std::size_t start = 0) const;
+
+        /**
+         *  Returns the state index for a state name.
+         */
+        std::size_t getIndex(StringView name) const;
+
+        /**
+         *  Returns the state index for a state id.
+         */
+        std::size_t getIndex(int id) const;
+
+        /**
+         *  Returns the state at the given index.
+         */
+        State const& getState(std::size_t index) const;
+
+        /**
+         *  Returns the state the instance is currently in.
+         */
+        State const& getCurrentState(AutomatonInstance const& instance) const;
+
+        /**
+         *  Returns the amount of states.
+         */
+        std::size_t stateCount() const;
+
+        /**
+         *  Returns the amount of transitions.
+         */
+        std::size_t edgeCount() const;
+
+        /**
+         *  Returns the first outgoing edge of a state.
+         */
+        Edge const* edgesBegin(std::size_t state) const;
+
+        /**
+         *  Returns one past the last outgoing edge of a state.
+         */
+        Edge const* edgesEnd(std::size_t state) const;
+
+        /**
+         *  Returns a table with one entry per state. An entry is the state index every instance
+         *  in that state moves to without calling a guard or an action (a single unconditional edge
+         *  into a state without action), deadEnd for states without outgoing edges,
+         *  or generalPath if the state has to be stepped by advance().
+         */
+        std::uint32_t const* forcedSuccessors() const;
+
+        /**
+         *  Returns true, if all transitions of the state have conditions depending on signals only.
+         *  An instance that found none of them active can then sleep until dependencyStamp() changes.
+         */
+        bool isEventDriven(std::size_t state) const;
+
+        /**
+         *  Returns a stamp that changes whenever a signal the transitions of the state depend on is notified.
+         */
+        std::uint64_t dependencyStamp(std::size_t state) const;
+
+        /**
+         *  Collects all edges of the current state whose trigger condition is true.
+         *  Symbol labeled edges are not considered.
+         */
+        void getActiveEdges(AutomatonInstance const& instance, EdgeSet& result) const;
+
+        /**
+         *  Moves the instance along the edge and calls the action of the target state.
+         */
+        void perform(AutomatonInstance& instance, Edge const& edge) const;
+
+        /**
+         *  Feeds one input symbol to the instance. Takes one of the transitions labeled with the symbol
+         *  whose condition is true, at random by weight if multiple are.
+         *
+         *  @return Returns true, if a transition has been made.
+         */
+        bool consume(AutomatonInstance& instance, std::uint8_t symbol) const;
+
+        /**
+         *  Transition to the next state, if possible. Selects a random transition by weight, if multiple are active.
+         *  States whose transitions are all unconditional are sampled in constant time. Does not allocate.
+         *
+         *  @return Returns true, if a transition has been made.
+         */
+        bool advance(AutomatonInstance& instance) const;
+
+        /**
+         *  Transition to the next state, if possible. Calls the selector function, if multiple are active.
+         *  The active set is caller provided scratch space, so a definition can be shared between threads.
+         *
+         *  @return Returns true, if a transition has been made.
+         */
+        template <typename SelectorT>
+        bool advance(AutomatonInstance& instance, EdgeSet& active, SelectorT&& selector) const
+        {
+            getActiveEdges(instance, active);
+            if (active.empty())
+                return false;
+
+            if (active.size() == 1)
+            {
+                perform(instance, *active.first());
+                return true;
+            }
+
+            Edge const* chosen = *selector(static_cast <EdgeSet const&> (active));
+            perform(instance, *chosen);
+            return true;
+        }
+
+    private:
+        // Mappings
+        NameTable nameMappings_;
+        std::unordered_map <int, std::size_t> idMappings_;
+
+        std::vector <State> states_;
+
+        // Outgoing edges of state i are edges_[edgeOffsets_[i], edgeOffsets_[i + 1]).
+        std::vector <std::size_t> edgeOffsets_;
+        std::vector <Edge> edges_;
+
+        std::vector <std::uint32_t> forcedSuccessors_;
+        std::vector <bool> eventDriven_;
+
+        // Edges without symbols of states where all of them are unconditional, sampled by weight.
+        // Row i of the alias table picks among aliasEdges_[aliasTable_.rowOffset(i), ...).
+        std::vector <bool> unguarded_;
+        std::vector <std::uint32_t> aliasEdges_;
+        AliasTable aliasTable_;
+    };
+
+    /**
+     *  Builds a shareable definition from the automaton.
+     */
+    std::shared_ptr <AutomatonDefinition const> makeDefinition(Automaton const& automaton);
+}
@@ -0,0 +1,276 @@
+#include "determinize.hpp"
+#include "definition.hpp"
+#include "nfa.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace MiniAutomata
+{
+//#####################################################################################################################
+    double DeterminizationReport::blowUp() const
+    {
+        return nfaStates == 0 ? 0. : static_cast <double> (subsetStates) / static_cast <double> (nfaStates);
+    }
+//#####################################################################################################################
+    Dfa determinize(
+        AutomatonDefinition const& definition,
+        DeterminizationReport& report,
+        std::size_t start,
+        std::size_t maxStates
+    )
+    {
+        Nfa nfa{definition, start};
+        auto classCount = nfa.getByteClasses().count();
+
+        // subset construction, dfa state i stands for the nfa states subsets[i].
+        std::unordered_map <Nfa::StateSet, std::uint32_t, Nfa::StateSetHash> known;
+        std::vector <Nfa::StateSet const*> subsets;
+        std::vector <std::uint32_t> transitions;
+        std::vector <bool> accepting;
+
+        auto intern = [&](Nfa::StateSet const& states) -> std::uint32_t {
+            if (states.empty())
+                return Dfa::deadState;
+
+            auto iter = known.find(states);
+            if (iter != std::end(known))
+                return iter->second;
+
+            if (subsets.size() >= maxStates)
+                throw std::length_error("subset construction exceeds the maximum amount of dfa states");
+
+            auto index = static_cast <std::uint32_t> (subsets.size());
+            iter = known.emplace(states, index).first;
+            subsets.push_back(&iter->first);
+            accepting.push_back(nfa.isAccepting(states));
+            transitions.resize(transitions.size() + classCount, Dfa::deadState);
+            return index;
+        };
+
+        auto startState = intern(nfa.getStartSet());
+        Nfa::StateSet next;
+        for (std::size_t current = 0; current < subsets.size(); ++current)
+        {
+            for (std::size_t c = 0; c != classCount; ++c)
+            {
+                nfa.step(*subsets[current], c, next);
+                auto target = intern(next);
+                transitions[current * classCount + c] = target;
+            }
+        }
+
+        Dfa subsetDfa{nfa.getByteClasses(), transitions, accepting, startState};
+        auto minimal = minimize(subsetDfa);
+
+        report.nfaStates = nfa.stateCount();
+        report.subsetStates = subsetDfa.stateCount();
+        report.minimizedStates = minimal.stateCount();
+        report.byteClasses = classCount;
+        return minimal;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Dfa determinize(AutomatonDefinition const& definition, std::size_t start)
+    {
+        DeterminizationReport report;
+        return determinize(definition, report, start);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Dfa minimize(Dfa const& dfa)
+    {
+        auto const& classes = dfa.getByteClasses();
+        auto classCount = classes.count();
+        std::vector <std::uint8_t> representatives(classCount);
+        for (std::size_t c = 0; c != classCount; ++c)
+            representatives[c] = classes.representative(c);
+
+        // keep reachable states only, the dead state is made explicit as the last state.
+        std::vector <std::uint32_t> index(dfa.stateCount(), Dfa::deadState);
+        std::vector <std::uint32_t> reachable{dfa.getStart()};
+        index[dfa.getStart()] = 0;
+        for (std::size_t i = 0; i < reachable.size(); ++i)
+        {
+            for (std::size_t c = 0; c != classCount; ++c)
+            {
+                auto target = dfa.next(reachable[i], representatives[c]);
+                if (target != Dfa::deadState && index[target] == Dfa::deadState)
+                {
+                    index[target] = static_cast <std::uint32_t> (reachable.size());
+                    reachable.push_back(target);
+                }
+            }
+        }
+
+        auto const n = reachable.size() + 1;
+        auto const dead = static_cast <std::uint32_t> (n - 1);
+        std::vector <std::uint32_t> delta(n * classCount, dead);
+        for (std::size_t i = 0; i != reachable.size(); ++i)
+        {
+            for (std::size_t c = 0; c != classCount; ++c)
+            {
+                auto target = dfa.next(reachable[i], representatives[c]);
+                if (target != Dfa::deadState)
+                    delta[i * classCount + c] = index[target];
+            }
+        }
+
+        // predecessors of state t on class c are predecessors[predecessorOffsets[t * classCount + c], ...).
+        std::vector <std::size_t> predecessorOffsets(n * classCount + 1, 0);
+        for (std::size_t s = 0; s != n; ++s)
+            for (std::size_t c = 0; c != classCount; ++c)
+                ++predecessorOffsets[delta[s * classCount + c] * classCount + c + 1];
+        for (std::size_t i = 1; i < predecessorOffsets.size(); ++i)
+            predecessorOffsets[i] += predecessorOffsets[i - 1];
+        std::vector <std::uint32_t> predecessors(predecessorOffsets.back());
+        {
+            auto cursor = predecessorOffsets;
+            for (std::size_t s = 0; s != n; ++s)
+                for (std::size_t c = 0; c != classCount; ++c)
+                    predecessors[cursor[delta[s * classCount + c] * classCount + c]++] = static_cast <std::uint32_t> (s);
+        }
+
+        // refinable partition: the elements of a block are contiguous in elements.
+        struct Block
+        {
+            std::size_t first;
+            std::size_t last;
+            std::size_t marked;
+        };
+        std::vector <std::uint32_t> elements(n);
+        std::vector <std::size_t> location(n);
+        std::vector <std::uint32_t> blockOf(n);
+        std::vector <Block> blocks;
+
+        {
+            std::size_t position = 0;
+            for (int pass = 0; pass != 2; ++pass)
+            {
+                auto first = position;
+                for (std::size_t s = 0; s != n; ++s)
+                {
+                    bool accepts = s != dead && dfa.isAccepting(reachable[s]);
+                    if (accepts == (pass == 0))
+                    {
+                        elements[position] = static_cast <std::uint32_t> (s);
+                        location[s] = position++;
+                        blockOf[s] = static_cast <std::uint32_t> (blocks.size());
+                    }
+                }
+                if (position != first)
+                    blocks.push_back({first, position, 0});
+            }
+        }
+
+        std::vector <std::pair <std::uint32_t, std::uint32_t>> worklist;
+        std::vector <bool> inWorklist(blocks.size() * classCount, false);
+        for (std::uint32_t b = 0; b != blocks.size(); ++b)
+        {
+            for (std::uint32_t c = 0; c != classCount; ++c)
+            {
+                worklist.emplace_back(b, c);
+                inWorklist[b * classCount + c] = true;
+            }
+        }
+
+        std::vector <std::uint32_t> splitter;
+        std::vector <std::uint32_t> touched;
+        while (!worklist.empty())
+        {
+            auto block = worklist.back().first;
+            auto c = worklist.back().second;
+            worklist.pop_back();
+            inWorklist[block * classCount + c] = false;
+
+            splitter.clear();
+            for (auto i = blocks[block].first; i != blocks[block].last; ++i)
+            {
+                auto t = elements[i];
+                splitter.insert(
+                    std::end(splitter),
+                    std::begin(predecessors) + predecessorOffsets[t * classCount + c],
+                    std::begin(predecessors) + predecessorOffsets[t * classCount + c + 1]
+                );
+            }
+
+            // move marked states to the front of their block.
+            touched.clear();
+            for (auto s : splitter)
+            {
+                auto& b = blocks[blockOf[s]];
+                auto position = location[s];
+                auto front = b.first + b.marked;
+                if (position < front)
+                    continue;
+                if (b.marked == 0)
+                    touched.push_back(blockOf[s]);
+                std::swap(elements[position], elements[front]);
+                location[elements[position]] = position;
+                location[elements[front]] = front;
+                ++b.marked;
+            }
+
+            for (auto b : touched)
+            {
+                auto marked = blocks[b].marked;
+                blocks[b].marked = 0;
+                if (marked == blocks[b].last - blocks[b].first)
+                    continue;
+
+                // the marked part becomes a new block.
+                auto created = static_cast <std::uint32_t> (blocks.size());
+                blocks.push_back({blocks[b].first, blocks[b].first + marked, 0});
+                blocks[b].first += marked;
+                for (auto i = blocks[created].first; i != blocks[created].last; ++i)
+                    blockOf[elements[i]] = created;
+
+                inWorklist.resize(blocks.size() * classCount, false);
+                auto createdSize = blocks[created].last - blocks[created].first;
+                auto remainingSize = blocks[b].last - blocks[b].first;
+                for (std::uint32_t d = 0; d != classCount; ++d)
+                {
+                    auto add = (inWorklist[b * classCount + d] || createdSize <= remainingSize) ? created : b;
+                    if (!inWorklist[add * classCount + d])
+                    {
+                        worklist.emplace_back(add, d);
+                        inWorklist[add * classCount + d] = true;
+                    }
+                }
+            }
+        }
+
+        // every block except the one of the dead state becomes a state.
+        auto deadBlock = blockOf[dead];
+        std::vector <std::uint32_t> blockIndex(blocks.size(), Dfa::deadState);
+        std::vector <std::uint32_t> blockStates;
+        auto assign = [&](std::uint32_t b) {
+            if (blockIndex[b] == Dfa::deadState)
+            {
+                blockIndex[b] = static_cast <std::uint32_t> (blockStates.size());
+                blockStates.push_back(b);
+            }
+        };
+
+        // a start state equivalent to the dead state still has to exist.
+        assign(blockOf[0]);
+        for (std::uint32_t s = 0; s != dead; ++s)
+            if (blockOf[s] != deadBlock)
+                assign(blockOf[s]);
+
+        std::vector <std::uint32_t> transitions(blockStates.size() * classCount, Dfa::deadState);
+        std::vector <bool> accepting(blockStates.size(), false);
+        for (std::size_t i = 0; i != blockStates.size(); ++i)
+        {
+            auto representative = elements[blocks[blockStates[i]].first];
+            accepting[i] = representative != dead && dfa.isAccepting(reachable[representative]);
+            for (std::size_t c = 0; c != classCount; ++c)
+            {
+                auto targetBlock = blockOf[delta[representative * classCount + c]];
+                if (targetBlock != deadBlock)
+                    transitions[i * classCount + c] = blockIndex[targetBlock];
+            }
+        }
+        return Dfa{classes, transitions, accepting, blockIndex[blockOf[0]]};
+    }
+//#####################################################################################################################
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "automata_fwd.hpp"
+#include "dfa.hpp"
+
+#include <cstddef>
+
+namespace MiniAutomata
+{
+    /**
+     *  Sizes observed while turning a nondeterministic automaton into a minimal dfa.
+     */
+    struct DeterminizationReport
+    {
+        std::size_t nfaStates;
+        std::size_t subsetStates;
+        std::size_t minimizedStates;
+        std::size_t byteClasses;
+
+        /**
+         *  Returns subset states per nfa state, the blow up caused by the subset construction.
+         */
+        double blowUp() const;
+    };
+
+    /**
+     *  Turns the symbol labeled transitions of a definition into a minimal dfa.
+     *  Epsilon transitions are resolved by precomputed epsilon closures, then the subset construction
+     *  creates one dfa state per reachable set of definition states, which is finally minimized.
+     *  Transitions without symbols are ignored, guarded symbol transitions are rejected with std::invalid_argument.
+     *  Throws std::length_error, if the subset construction would exceed maxStates states.
+     */
+    Dfa determinize(
+        AutomatonDefinition const& definition,
+        DeterminizationReport& report,
+        std::size_t start = 0,
+        std::size_t maxStates = 1 << 20
+    );
+
+    /**
+     *  Turns the symbol labeled transitions of a definition into a minimal dfa.
+     */
+    Dfa determinize(AutomatonDefinition const& definition, std::size_t start = 0);
+
+    /**
+     *  Returns the minimal dfa recognizing the same language (Hopcroft's algorithm).
+     *  Unreachable states and states that can never reach an accepting state are removed.
+     */
+    Dfa minimize(Dfa const& dfa);
+}
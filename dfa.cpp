@@ -0,0 +1,192 @@
+#include "dfa.hpp"
+#include "definition.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace MiniAutomata
+{
+	using namespace std::string_literals;
+//#####################################################################################################################
+    constexpr std::uint32_t Dfa::deadState;
+//---------------------------------------------------------------------------------------------------------------------
+    Dfa::Dfa(AutomatonDefinition const& definition, std::size_t start)
+        : classes_{}
+        , stateCount_{definition.stateCount()}
+        , table_{}
+        , accepting_(definition.stateCount(), false)
+        , start_{static_cast <std::uint32_t> (start)}
+    {
+        if (start >= stateCount_)
+            throw std::invalid_argument(("no such state with index '"s + std::to_string(start) + "' in definition").c_str());
+
+        for (std::size_t state = 0; state != stateCount_; ++state)
+        {
+            accepting_[state] = definition.getState(state).isAccepting();
+            for (auto i = definition.edgesBegin(state); i != definition.edgesEnd(state); ++i)
+            {
+                if (!i->symbols)
+                    continue;
+                if (i->symbols->isEpsilon())
+                    throw std::invalid_argument("epsilon transitions cannot be put into a jump table, determinize first");
+                if (!i->trigger.isUnconditional())
+                    throw std::invalid_argument("guarded symbol transitions cannot be put into a jump table");
+                classes_.split(i->symbols->bits());
+            }
+        }
+
+        auto classCount = classes_.count();
+        std::vector <std::uint32_t> transitions(stateCount_ * classCount, deadState);
+        for (std::size_t state = 0; state != stateCount_; ++state)
+        {
+            for (auto i = definition.edgesBegin(state); i != definition.edgesEnd(state); ++i)
+            {
+                if (!i->symbols)
+                    continue;
+
+                auto const& bits = i->symbols->bits();
+                for (unsigned int byte = 0; byte != 256; ++byte)
+                {
+                    if (!bits.test(byte))
+                        continue;
+
+                    auto& entry = transitions[state * classCount + classes_.classOf(static_cast <std::uint8_t> (byte))];
+                    if (entry != deadState && entry != i->to)
+                        throw std::invalid_argument((
+                            "state '"s + definition.getState(state).getName().to_string() +
+                            "' has multiple transitions on symbol " + std::to_string(byte) + ", determinize first"
+                        ).c_str());
+                    entry = static_cast <std::uint32_t> (i->to);
+                }
+            }
+        }
+        buildTable(transitions);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Dfa::Dfa(
+        ByteClasses const& classes,
+        std::vector <std::uint32_t> const& transitions,
+        std::vector <bool> const& accepting,
+        std::uint32_t start
+    )
+        : classes_{classes}
+        , stateCount_{accepting.size()}
+        , table_{}
+        , accepting_{accepting}
+        , start_{start}
+    {
+        if (transitions.size() != stateCount_ * classes_.count())
+            throw std::invalid_argument("transition table size does not match state and class count");
+        if (start_ >= stateCount_)
+            throw std::invalid_argument("start state out of range");
+        for (std::size_t i = 0; i != transitions.size(); ++i)
+        {
+            if (transitions[i] != deadState && transitions[i] >= stateCount_)
+            {
+                throw std::invalid_argument((
+                    "transition table entry "s + std::to_string(i) + " refers to state " + std::to_string(transitions[i]) +
+                    ", but the dfa has " + std::to_string(stateCount_) + " states"
+                ).c_str());
+            }
+        }
+        buildTable(transitions);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Dfa::buildTable(std::vector <std::uint32_t> const& transitions)
+    {
+        auto classCount = classes_.count();
+        if ((stateCount_ + 1) * classCount > 0xFFFFFFFFull)
+            throw std::length_error("dfa too large for 32 bit jump table");
+
+        auto deadRow = static_cast <std::uint32_t> (stateCount_ * classCount);
+        table_.assign((stateCount_ + 1) * classCount, deadRow);
+        for (std::size_t i = 0; i != transitions.size(); ++i)
+        {
+            if (transitions[i] != deadState)
+                table_[i] = static_cast <std::uint32_t> (transitions[i] * classCount);
+        }
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint32_t Dfa::run(std::uint8_t const* data, std::size_t size) const
+    {
+        return run(start_, data, size);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint32_t Dfa::run(std::uint32_t state, std::uint8_t const* data, std::size_t size) const
+    {
+        if (state == deadState)
+            return deadState;
+        checkState(state);
+
+        auto const classCount = static_cast <std::uint32_t> (classes_.count());
+        auto const deadRow = static_cast <std::uint32_t> (stateCount_ * classCount);
+        auto const* table = table_.data();
+        auto const* classes = classes_.map().data();
+
+        std::uint32_t row = state * classCount;
+        std::size_t i = 0;
+
+        // the dead row is absorbing, so it is enough to check for it once per block.
+        for (; i + 8 <= size; i += 8)
+        {
+            row = table[row + classes[data[i]]];
+            row = table[row + classes[data[i + 1]]];
+            row = table[row + classes[data[i + 2]]];
+            row = table[row + classes[data[i + 3]]];
+            row = table[row + classes[data[i + 4]]];
+            row = table[row + classes[data[i + 5]]];
+            row = table[row + classes[data[i + 6]]];
+            row = table[row + classes[data[i + 7]]];
+            if (row == deadRow)
+                return deadState;
+        }
+        for (; i != size; ++i)
+            row = table[row + classes[data[i]]];
+
+        return row == deadRow ? deadState : row / classCount;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Dfa::matches(std::uint8_t const* data, std::size_t size) const
+    {
+        return isAccepting(run(data, size));
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint32_t Dfa::next(std::uint32_t state, std::uint8_t symbol) const
+    {
+        return run(state, &symbol, 1);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Dfa::isAccepting(std::uint32_t state) const
+    {
+        if (state == deadState)
+            return false;
+        checkState(state);
+        return accepting_[state];
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Dfa::checkState(std::uint32_t state) const
+    {
+        if (state >= stateCount_)
+        {
+            throw std::invalid_argument((
+                "dfa state "s + std::to_string(state) + " out of range, the dfa has " + std::to_string(stateCount_) + " states"
+            ).c_str());
+        }
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint32_t Dfa::getStart() const
+    {
+        return start_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t Dfa::stateCount() const
+    {
+        return stateCount_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    ByteClasses const& Dfa::getByteClasses() const
+    {
+        return classes_;
+    }
+//#####################################################################################################################
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "automata_fwd.hpp"
+#include "symbols.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace MiniAutomata
+{
+    /**
+     *  A deterministic recognizer over byte streams, stepping through a dense state x byte class jump table.
+     *  Built from the symbol labeled transitions of a definition, guards and actions are not part of it.
+     */
+    class Dfa
+    {
+    public:
+        constexpr static std::uint32_t deadState = 0xFFFFFFFFu;
+
+    public:
+        /**
+         *  Builds the jump table from the symbol labeled transitions of the definition.
+         *  Dfa states have the same indices as the definition states. Transitions without symbols are ignored.
+         *  Throws std::invalid_argument for guarded or epsilon transitions and for states
+         *  that have multiple transitions on the same symbol (use determinize() for those).
+         */
+        explicit Dfa(AutomatonDefinition const& definition, std::size_t start = 0);
+
+        /**
+         *  Builds a dfa from a raw transition table.
+         *
+         *  @param classes The byte classes forming the columns of the table.
+         *  @param transitions Row major table with classes.count() entries per state. Entries are states or deadState.
+         *  @param accepting One entry per state.
+         *  @param start The start state.
+         *
+         *  Throws std::invalid_argument, if the table size does not match, or an entry or the start is out of range.
+         */
+        Dfa(
+            ByteClasses const& classes,
+            std::vector <std::uint32_t> const& transitions,
+            std::vector <bool> const& accepting,
+            std::uint32_t start
+        );
+
+        /**
+         *  Consumes the whole buffer, starting at the start state.
+         *
+         *  @return Returns the state reached, or deadState if some symbol had no transition.
+         */
+        std::uint32_t run(std::uint8_t const* data, std::size_t size) const;
+
+        /**
+         *  Consumes the whole buffer, starting at the given state. Can be used to continue a previous run.
+         *  Throws std::invalid_argument, if the state is neither deadState nor a state of the dfa.
+         *
+         *  @return Returns the state reached, or deadState if some symbol had no transition.
+         */
+        std::uint32_t run(std::uint32_t state, std::uint8_t const* data, std::size_t size) const;
+
+        /**
+         *  Returns true, if consuming the buffer from the start state ends in an accepting state.
+         */
+        bool matches(std::uint8_t const* data, std::size_t size) const;
+
+        /**
+         *  Returns the state reached from state with the symbol, or deadState.
+         */
+        std::uint32_t next(std::uint32_t state, std::uint8_t symbol) const;
+
+        /**
+         *  Returns true, if the state is accepting. The dead state never is.
+         */
+        bool isAccepting(std::uint32_t state) const;
+
+        /**
+         *  Returns the start state.
+         */
+        std::uint32_t getStart() const;
+
+        /**
+         *  Returns the amount of states, not counting the dead state.
+         */
+        std::size_t stateCount() const;
+
+        /**
+         *  Returns the byte classes forming the columns of the jump table.
+         */
+        ByteClasses const& getByteClasses() const;
+
+    private:
+        void buildTable(std::vector <std::uint32_t> const& transitions);
+        void checkState(std::uint32_t state) const;
+
+    private:
+        ByteClasses classes_;
+        std::size_t stateCount_;
+
+        // Entries are premultiplied row offsets, the last row belongs to the dead state.
+        std::vector <std::uint32_t> table_;
+        std::vector <bool> accepting_;
+        std::uint32_t start_;
+    };
+}
@@ -0,0 +1,216 @@
+#include "instrumentation.hpp"
+#include "automata.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace MiniAutomata
+{
+    namespace
+    {
+        constexpr std::size_t latencyBuckets = std::tuple_size <decltype(GuardLatency::buckets)>::value;
+
+        // Identifies the instrumentation of a cached shard, ids are never reused unlike addresses.
+        struct ShardCacheEntry
+        {
+            std::uint64_t instrumentation;
+            void* shard;
+        };
+
+        // The shards of the instrumentations a thread used last, most recently used first,
+        // so a thread stepping several instrumented automata in turn does not take the lock.
+        constexpr std::size_t shardCacheSize = 8;
+        thread_local std::array <ShardCacheEntry, shardCacheSize> shardCache{};
+        std::atomic <std::uint64_t> nextInstrumentationId{1};
+
+        std::unique_ptr <std::atomic <std::uint64_t>[]> makeCounters(std::size_t count)
+        {
+            // value initialization zeroes the atomics.
+            return std::unique_ptr <std::atomic <std::uint64_t>[]> (new std::atomic <std::uint64_t>[count]());
+        }
+
+        void increment(std::atomic <std::uint64_t>& counter, std::uint64_t amount)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+
+        std::size_t latencyBucket(std::uint64_t nanoseconds)
+        {
+            std::size_t bucket = 0;
+            for (; nanoseconds != 0 && bucket + 1 != latencyBuckets; nanoseconds >>= 1)
+                ++bucket;
+            return bucket;
+        }
+    }
+//#####################################################################################################################
+    std::chrono::nanoseconds GuardLatency::quantile(double q) const
+    {
+        auto rank = static_cast <std::uint64_t> (std::ceil(std::min(std::max(q, 0.), 1.) * static_cast <double> (evaluations)));
+        std::uint64_t seen = 0;
+        for (std::size_t bucket = 0; bucket != buckets.size(); ++bucket)
+        {
+            seen += buckets[bucket];
+            if (seen >= rank && seen != 0)
+                return std::chrono::nanoseconds{std::uint64_t{1} << bucket};
+        }
+        return std::chrono::nanoseconds{0};
+    }
+//#####################################################################################################################
+    Instrumentation::Instrumentation(std::size_t stateCount, std::size_t transitionCount)
+        : id_{nextInstrumentationId.fetch_add(1, std::memory_order_relaxed)}
+        , stateCount_{stateCount}
+        , transitionCount_{transitionCount}
+        , mutex_{}
+        , shards_{}
+    {
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Instrumentation::Instrumentation(Automaton const& automaton)
+        : Instrumentation{automaton.stateCount(), automaton.transitionCount()}
+    {
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Instrumentation::~Instrumentation() = default;
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint64_t Instrumentation::now()
+    {
+        return static_cast <std::uint64_t> (
+            std::chrono::duration_cast <std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count()
+        );
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Instrumentation::Shard& Instrumentation::shard()
+    {
+        auto& cache = shardCache;
+        if (cache[0].instrumentation == id_)
+            return *static_cast <Shard*> (cache[0].shard);
+        for (std::size_t i = 1; i != shardCacheSize; ++i)
+        {
+            if (cache[i].instrumentation == id_)
+            {
+                std::rotate(std::begin(cache), std::begin(cache) + i, std::begin(cache) + i + 1);
+                return *static_cast <Shard*> (cache[0].shard);
+            }
+        }
+
+        std::lock_guard <std::mutex> lock{mutex_};
+        auto owner = std::this_thread::get_id();
+        auto iter = std::find_if(std::begin(shards_), std::end(shards_), [owner](std::unique_ptr <Shard> const& shard) {
+            return shard->owner == owner;
+        });
+        if (iter == std::end(shards_))
+        {
+            std::unique_ptr <Shard> shard{new Shard{
+                owner,
+                makeCounters(stateCount_),
+                makeCounters(stateCount_),
+                makeCounters(transitionCount_),
+                makeCounters(transitionCount_),
+                makeCounters(transitionCount_ * latencyBuckets)
+            }};
+            shards_.push_back(std::move(shard));
+            iter = std::end(shards_) - 1;
+        }
+        std::rotate(std::begin(cache), std::end(cache) - 1, std::end(cache));
+        cache[0] = ShardCacheEntry{id_, iter->get()};
+        return **iter;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Instrumentation::recordTransition(std::size_t from, std::size_t to, std::size_t transition, std::uint64_t dwell)
+    {
+        auto& counters = shard();
+        if (from < stateCount_)
+            increment(counters.dwell[from], dwell);
+        if (to < stateCount_)
+            increment(counters.visits[to], 1);
+        if (transition < transitionCount_)
+            increment(counters.fires[transition], 1);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Instrumentation::recordGuard(std::size_t transition, std::uint64_t nanoseconds)
+    {
+        if (transition >= transitionCount_)
+            return;
+
+        auto& counters = shard();
+        increment(counters.guardNanos[transition], nanoseconds);
+        increment(counters.guardBuckets[transition * latencyBuckets + latencyBucket(nanoseconds)], 1);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint64_t Instrumentation::fireCount(std::size_t transition) const
+    {
+        if (transition >= transitionCount_)
+            return 0;
+        return sum([transition](Shard const& shard) -> std::atomic <std::uint64_t> const& {
+            return shard.fires[transition];
+        });
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint64_t Instrumentation::visitCount(std::size_t state) const
+    {
+        if (state >= stateCount_)
+            return 0;
+        return sum([state](Shard const& shard) -> std::atomic <std::uint64_t> const& {
+            return shard.visits[state];
+        });
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::chrono::nanoseconds Instrumentation::dwellTime(std::size_t state) const
+    {
+        if (state >= stateCount_)
+            return std::chrono::nanoseconds{0};
+        return std::chrono::nanoseconds{sum([state](Shard const& shard) -> std::atomic <std::uint64_t> const& {
+            return shard.dwell[state];
+        })};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    GuardLatency Instrumentation::guardLatency(std::size_t transition) const
+    {
+        GuardLatency result{0, std::chrono::nanoseconds{0}, {}};
+        if (transition >= transitionCount_)
+            return result;
+
+        result.total = std::chrono::nanoseconds{sum([transition](Shard const& shard) -> std::atomic <std::uint64_t> const& {
+            return shard.guardNanos[transition];
+        })};
+        for (std::size_t bucket = 0; bucket != latencyBuckets; ++bucket)
+        {
+            result.buckets[bucket] = sum([transition, bucket](Shard const& shard) -> std::atomic <std::uint64_t> const& {
+                return shard.guardBuckets[transition * latencyBuckets + bucket];
+            });
+            result.evaluations += result.buckets[bucket];
+        }
+        return result;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Instrumentation::reset()
+    {
+        std::lock_guard <std::mutex> lock{mutex_};
+        for (auto const& shard : shards_)
+        {
+            for (std::size_t i = 0; i != stateCount_; ++i)
+            {
+                shard->visits[i].store(0, std::memory_order_relaxed);
+                shard->dwell[i].store(0, std::memory_order_relaxed);
+            }
+            for (std::size_t i = 0; i != transitionCount_; ++i)
+            {
+                shard->fires[i].store(0, std::memory_order_relaxed);
+                shard->guardNanos[i].store(0, std::memory_order_relaxed);
+            }
+            for (std::size_t i = 0; i != transitionCount_ * latencyBuckets; ++i)
+                shard->guardBuckets[i].store(0, std::memory_order_relaxed);
+        }
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t Instrumentation::stateCount() const
+    {
+        return stateCount_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t Instrumentation::transitionCount() const
+    {
+        return transitionCount_;
+    }
+//#####################################################################################################################
+}
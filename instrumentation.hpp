@@ -0,0 +1,133 @@
+#pragma once
+
+#include "automata_fwd.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MiniAutomata
+{
+    /**
+     *  Evaluation times of one guard. Bucket i counts evaluations that took [2^(i-1), 2^i) nanoseconds,
+     *  bucket 0 those below one nanosecond, the last one everything above.
+     */
+    struct GuardLatency
+    {
+        std::uint64_t evaluations;
+        std::chrono::nanoseconds total;
+        std::array <std::uint64_t, 40> buckets;
+
+        /**
+         *  Returns the upper bound of the bucket holding the given quantile in [0, 1].
+         */
+        std::chrono::nanoseconds quantile(double q) const;
+    };
+
+    /**
+     *  Counts what automata do: how often each transition fires, how often each state is entered
+     *  and how long it is stayed in, and how long guards take to evaluate.
+     *  Attach it with Automaton::setInstrumentation. Automata without one only pay for a null check.
+     *
+     *  Transitions are identified by Transition::getSequence(), states by their index.
+     *  Every thread records into its own counters, which are summed up when read, so any number of
+     *  automata on any number of threads can share one instrumentation. Each thread costs
+     *  about 16 bytes per state and 340 bytes per transition.
+     */
+    class Instrumentation
+    {
+    public:
+        /**
+         *  Makes room for the given amount of states and transitions. Larger indices are not recorded.
+         */
+        Instrumentation(std::size_t stateCount, std::size_t transitionCount);
+
+        /**
+         *  Makes room for the states and transitions of the automaton.
+         */
+        explicit Instrumentation(Automaton const& automaton);
+
+        ~Instrumentation();
+
+        Instrumentation(Instrumentation const&) = delete;
+        Instrumentation& operator=(Instrumentation const&) = delete;
+
+        /**
+         *  Returns how often the transition was taken.
+         */
+        std::uint64_t fireCount(std::size_t transition) const;
+
+        /**
+         *  Returns how often the state was entered by a transition.
+         */
+        std::uint64_t visitCount(std::size_t state) const;
+
+        /**
+         *  Returns the time spent in the state until a transition left it.
+         */
+        std::chrono::nanoseconds dwellTime(std::size_t state) const;
+
+        /**
+         *  Returns the evaluation times of the guard of the transition. Unconditional transitions have none.
+         */
+        GuardLatency guardLatency(std::size_t transition) const;
+
+        /**
+         *  Sets all counters to zero. Counts recorded concurrently may be lost.
+         */
+        void reset();
+
+        std::size_t stateCount() const;
+        std::size_t transitionCount() const;
+
+        /**
+         *  Returns a nanosecond time stamp of the clock used for dwell times and latencies.
+         */
+        static std::uint64_t now();
+
+    private:
+        friend Automaton;
+        friend Transition;
+
+        using Counters = std::unique_ptr <std::atomic <std::uint64_t>[]>;
+
+        // Written by one thread only, so increments need no read-modify-write.
+        struct Shard
+        {
+            std::thread::id owner;
+            Counters visits;
+            Counters dwell;
+            Counters fires;
+            Counters guardNanos;
+            Counters guardBuckets;
+        };
+
+        void recordTransition(std::size_t from, std::size_t to, std::size_t transition, std::uint64_t dwell);
+        void recordGuard(std::size_t transition, std::uint64_t nanoseconds);
+        Shard& shard();
+
+        template <typename FunctionT>
+        std::uint64_t sum(FunctionT&& counter) const
+        {
+            std::lock_guard <std::mutex> lock{mutex_};
+            std::uint64_t total = 0;
+            for (auto const& shard : shards_)
+                total += counter(*shard).load(std::memory_order_relaxed);
+            return total;
+        }
+
+    private:
+        std::uint64_t id_;
+        std::size_t stateCount_;
+        std::size_t transitionCount_;
+
+        mutable std::mutex mutex_;
+        std::vector <std::unique_ptr <Shard>> shards_;
+    };
+}
@@ -0,0 +1,147 @@
+#include "lazy_dfa.hpp"
+#include "dfa.hpp"
+
+namespace MiniAutomata
+{
+    namespace
+    {
+        // Bookkeeping bytes per cached state on top of its set and transition row.
+        constexpr std::size_t stateOverhead = 64;
+
+        // A flush only pays off if the cache survived at least this many bytes per state created.
+        constexpr std::size_t minBytesPerState = 10;
+    }
+//#####################################################################################################################
+    constexpr std::uint32_t LazyDfa::unknownState;
+//#####################################################################################################################
+    LazyDfa::LazyDfa(AutomatonDefinition const& definition, std::size_t memoryBudget, std::size_t start)
+        : nfa_{definition, start}
+        , classCount_{nfa_.getByteClasses().count()}
+        , memoryBudget_{memoryBudget}
+        , memoryUsed_{0}
+        , known_{}
+        , sets_{}
+        , accepting_{}
+        , table_{}
+        , scratch_{}
+        , statistics_{0, 0, 0}
+    {
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint32_t LazyDfa::intern(Nfa::StateSet const& states)
+    {
+        if (states.empty())
+            return Dfa::deadState;
+
+        auto iter = known_.find(states);
+        if (iter != std::end(known_))
+            return iter->second;
+
+        auto cost = classCount_ * sizeof(std::uint32_t) + 2 * states.size() * sizeof(std::uint32_t) + stateOverhead;
+        if (memoryUsed_ + cost > memoryBudget_)
+            return unknownState;
+
+        auto index = static_cast <std::uint32_t> (sets_.size());
+        iter = known_.emplace(states, index).first;
+        sets_.push_back(&iter->first);
+        accepting_.push_back(nfa_.isAccepting(states));
+        table_.resize(table_.size() + classCount_, unknownState);
+
+        memoryUsed_ += cost;
+        ++statistics_.statesCreated;
+        return index;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void LazyDfa::flush()
+    {
+        known_.clear();
+        sets_.clear();
+        accepting_.clear();
+        table_.clear();
+        memoryUsed_ = 0;
+        ++statistics_.cacheFlushes;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool LazyDfa::simulate(Nfa::StateSet states, std::uint8_t const* data, std::size_t size)
+    {
+        statistics_.simulatedBytes += size;
+
+        auto const& classes = nfa_.getByteClasses();
+        for (std::size_t i = 0; i != size && !states.empty(); ++i)
+        {
+            nfa_.step(states, classes.classOf(data[i]), scratch_);
+            states.swap(scratch_);
+        }
+        return nfa_.isAccepting(states);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool LazyDfa::matches(std::uint8_t const* data, std::size_t size)
+    {
+        auto const* classes = nfa_.getByteClasses().map().data();
+
+        auto state = intern(nfa_.getStartSet());
+        if (state == unknownState)
+        {
+            flush();
+            state = intern(nfa_.getStartSet());
+            if (state == unknownState)
+                return simulate(nfa_.getStartSet(), data, size);
+        }
+
+        bool flushed = false;
+        std::size_t flushPosition = 0;
+        auto createdAtFlush = statistics_.statesCreated;
+        for (std::size_t i = 0; i != size; ++i)
+        {
+            auto byteClass = classes[data[i]];
+            auto next = table_[state * classCount_ + byteClass];
+            if (next == unknownState)
+            {
+                nfa_.step(*sets_[state], byteClass, scratch_);
+                next = intern(scratch_);
+                if (next == unknownState)
+                {
+                    Nfa::StateSet current = *sets_[state];
+
+                    // fall back to the nfa, if the cache keeps thrashing.
+                    auto createdSinceFlush = statistics_.statesCreated - createdAtFlush;
+                    if (flushed && i - flushPosition < minBytesPerState * createdSinceFlush)
+                        return simulate(std::move(current), data + i, size - i);
+
+                    flush();
+                    flushed = true;
+                    flushPosition = i;
+                    createdAtFlush = statistics_.statesCreated;
+
+                    state = intern(current);
+                    nfa_.step(current, byteClass, scratch_);
+                    next = intern(scratch_);
+                    if (state == unknownState || next == unknownState)
+                        return simulate(std::move(current), data + i, size - i);
+                }
+                table_[state * classCount_ + byteClass] = next;
+            }
+
+            if (next == Dfa::deadState)
+                return false;
+            state = next;
+        }
+        return accepting_[state];
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t LazyDfa::cachedStates() const
+    {
+        return sets_.size();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t LazyDfa::memoryUsage() const
+    {
+        return memoryUsed_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    LazyDfa::Statistics const& LazyDfa::getStatistics() const
+    {
+        return statistics_;
+    }
+//#####################################################################################################################
+}
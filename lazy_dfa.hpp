@@ -0,0 +1,81 @@
+#pragma once
+
+#include "automata_fwd.hpp"
+#include "nfa.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace MiniAutomata
+{
+    /**
+     *  A dfa that is built while running. Dfa states are created from sets of nfa states the first time
+     *  they are reached and cached together with their transitions. When the cache exceeds its memory budget
+     *  it is flushed. If flushes happen so often that the cache does not pay off, the rest of the input is
+     *  handled by plain nfa simulation.
+     *  Not thread safe, use one per thread.
+     */
+    class LazyDfa
+    {
+    public:
+        struct Statistics
+        {
+            std::size_t statesCreated;
+            std::size_t cacheFlushes;
+            std::size_t simulatedBytes;
+        };
+
+    public:
+        /**
+         *  @param memoryBudget The bytes the state cache may occupy before it is flushed.
+         */
+        explicit LazyDfa(AutomatonDefinition const& definition, std::size_t memoryBudget = 1 << 20, std::size_t start = 0);
+
+        /**
+         *  Returns true, if consuming the buffer from the start state ends in an accepting state.
+         */
+        bool matches(std::uint8_t const* data, std::size_t size);
+
+        /**
+         *  Returns the amount of currently cached dfa states.
+         */
+        std::size_t cachedStates() const;
+
+        /**
+         *  Returns the bytes currently occupied by the state cache.
+         */
+        std::size_t memoryUsage() const;
+
+        /**
+         *  Returns counters accumulated over all runs.
+         */
+        Statistics const& getStatistics() const;
+
+    private:
+        constexpr static std::uint32_t unknownState = 0xFFFFFFFEu;
+
+        /**
+         *  Returns the cached state for the set, or unknownState if the budget does not allow another state.
+         */
+        std::uint32_t intern(Nfa::StateSet const& states);
+        void flush();
+        bool simulate(Nfa::StateSet states, std::uint8_t const* data, std::size_t size);
+
+    private:
+        Nfa nfa_;
+        std::size_t classCount_;
+        std::size_t memoryBudget_;
+        std::size_t memoryUsed_;
+
+        std::unordered_map <Nfa::StateSet, std::uint32_t, Nfa::StateSetHash> known_;
+        std::vector <Nfa::StateSet const*> sets_;
+        std::vector <bool> accepting_;
+
+        // Row major, classCount_ entries per cached state. Entries are states, deadState or unknownState.
+        std::vector <std::uint32_t> table_;
+
+        Nfa::StateSet scratch_;
+        Statistics statistics_;
+    };
+}
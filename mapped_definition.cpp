@@ -0,0 +1,444 @@
+#include "mapped_definition.hpp"
+#include "alias_table.hpp"
+#include "random.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace MiniAutomata
+{
+	using namespace std::string_literals;
+//#####################################################################################################################
+    namespace
+    {
+        char const imageMagic[8] = {'M', 'I', 'N', 'I', 'A', 'U', 'T', 'O'};
+        constexpr std::uint32_t imageByteOrder = 0x01020304u;
+        constexpr std::uint32_t noLabel = 0xFFFFFFFFu;
+        constexpr std::uint32_t emptySlot = 0xFFFFFFFFu;
+
+        struct Header
+        {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t byteOrder;
+            std::uint64_t size;
+
+            std::uint64_t stateCount;
+            std::uint64_t edgeCount;
+            std::uint64_t labelCount;
+            std::uint64_t aliasCount;
+            std::uint64_t idCount;
+            std::uint64_t nameBytes;
+            std::uint64_t hashSize;
+
+            // Section positions from the start of the image.
+            std::uint64_t edgeOffsets;
+            std::uint64_t edges;
+            std::uint64_t labels;
+            std::uint64_t aliasOffsets;
+            std::uint64_t aliasEdges;
+            std::uint64_t aliasProbability;
+            std::uint64_t aliasColumns;
+            std::uint64_t nameOffsets;
+            std::uint64_t names;
+            std::uint64_t nameHash;
+            std::uint64_t ids;
+        };
+
+        std::uint64_t hashName(StringView name)
+        {
+            // FNV-1a, so the table does not depend on the standard library that wrote it.
+            std::uint64_t hash = 0xcbf29ce484222325ull;
+            for (auto c : name)
+            {
+                hash ^= static_cast <unsigned char> (c);
+                hash *= 0x100000001b3ull;
+            }
+            return hash;
+        }
+
+        std::uint64_t alignSection(std::uint64_t position)
+        {
+            return (position + 7u) & ~std::uint64_t{7u};
+        }
+
+        std::uint32_t checkedCount(std::size_t count, char const* what)
+        {
+            if (count >= std::numeric_limits <std::uint32_t>::max())
+                throw std::length_error(("too many "s + what + " for a definition image").c_str());
+            return static_cast <std::uint32_t> (count);
+        }
+
+        template <typename T>
+        void writeSection(std::ostream& stream, std::uint64_t& position, std::uint64_t offset, std::vector <T> const& data)
+        {
+            static char const padding[8] = {};
+            stream.write(padding, static_cast <std::streamsize> (offset - position));
+            stream.write(reinterpret_cast <char const*> (data.data()), static_cast <std::streamsize> (data.size() * sizeof(T)));
+            position = offset + data.size() * sizeof(T);
+        }
+    }
+//#####################################################################################################################
+    void saveDefinition(AutomatonDefinition const& definition, std::ostream& stream)
+    {
+        using Edge = MappedDefinition::Edge;
+        using Label = MappedDefinition::Label;
+        using Id = MappedDefinition::Id;
+
+        auto stateCount = checkedCount(definition.stateCount(), "states");
+        checkedCount(definition.edgeCount(), "transitions");
+
+        std::vector <std::uint32_t> edgeOffsets;
+        std::vector <Edge> edges;
+        std::vector <Label> labels;
+        std::vector <std::size_t> aliasOffsets(1, 0);
+        std::vector <std::uint32_t> aliasEdges;
+        std::vector <double> aliasWeights;
+        edgeOffsets.reserve(stateCount + 1);
+        edges.reserve(definition.edgeCount());
+
+        for (std::size_t state = 0; state != stateCount; ++state)
+        {
+            edgeOffsets.push_back(static_cast <std::uint32_t> (edges.size()));
+            for (auto i = definition.edgesBegin(state); i != definition.edgesEnd(state); ++i)
+            {
+                if (!i->trigger.isUnconditional())
+                {
+                    throw std::invalid_argument((
+                        "state '"s + definition.getState(state).getName().to_string() +
+                        "' has a transition with a condition, which cannot be stored in an image"
+                    ).c_str());
+                }
+
+                Edge edge{static_cast <std::uint32_t> (i->to), noLabel, i->weight};
+                if (i->symbols)
+                {
+                    Label label{};
+                    auto const& bits = i->symbols->bits();
+                    for (std::size_t symbol = 0; symbol != 256; ++symbol)
+                        if (bits[symbol])
+                            label.bits[symbol / 64] |= std::uint64_t{1} << (symbol % 64);
+                    label.epsilon = i->symbols->isEpsilon() ? 1 : 0;
+
+                    edge.label = static_cast <std::uint32_t> (labels.size());
+                    labels.push_back(label);
+                }
+                else
+                {
+                    aliasEdges.push_back(static_cast <std::uint32_t> (edges.size()));
+                    aliasWeights.push_back(i->weight);
+                }
+                edges.push_back(edge);
+            }
+            aliasOffsets.push_back(aliasEdges.size());
+        }
+        edgeOffsets.push_back(static_cast <std::uint32_t> (edges.size()));
+
+        // the same tables the definition samples from.
+        AliasTable aliasTable{aliasOffsets, aliasWeights};
+        std::vector <std::uint32_t> aliasRows{std::begin(aliasOffsets), std::end(aliasOffsets)};
+        std::vector <double> aliasProbability{aliasTable.probabilities(), aliasTable.probabilities() + aliasEdges.size()};
+        std::vector <std::uint32_t> aliasColumns{aliasTable.aliases(), aliasTable.aliases() + aliasEdges.size()};
+
+        std::vector <std::uint32_t> nameOffsets;
+        std::vector <char> names;
+        std::vector <Id> ids;
+        nameOffsets.reserve(stateCount + 1);
+        for (std::size_t state = 0; state != stateCount; ++state)
+        {
+            auto const& stateObject = definition.getState(state);
+            nameOffsets.push_back(checkedCount(names.size(), "name bytes"));
+            names.insert(std::end(names), std::begin(stateObject.getName()), std::end(stateObject.getName()));
+            if (stateObject.getId())
+                ids.push_back(Id{static_cast <std::int32_t> (stateObject.getId().get()), static_cast <std::uint32_t> (state)});
+        }
+        nameOffsets.push_back(checkedCount(names.size(), "name bytes"));
+
+        // like the mappings of the definition, the first state with an id or name wins.
+        std::stable_sort(std::begin(ids), std::end(ids), [](Id const& lhs, Id const& rhs) {
+            return lhs.id < rhs.id;
+        });
+        ids.erase(std::unique(std::begin(ids), std::end(ids), [](Id const& lhs, Id const& rhs) {
+            return lhs.id == rhs.id;
+        }), std::end(ids));
+
+        std::size_t hashSize = 1;
+        while (hashSize < 2 * static_cast <std::size_t> (stateCount) + 1)
+            hashSize *= 2;
+        std::vector <std::uint32_t> nameHash(hashSize, emptySlot);
+        for (std::uint32_t state = 0; state != stateCount; ++state)
+        {
+            StringView name{names.data() + nameOffsets[state], nameOffsets[state + 1] - nameOffsets[state]};
+            for (auto slot = hashName(name) & (hashSize - 1);; slot = (slot + 1) & (hashSize - 1))
+            {
+                if (nameHash[slot] == emptySlot)
+                {
+                    nameHash[slot] = state;
+                    break;
+                }
+                auto other = nameHash[slot];
+                if (name == StringView{names.data() + nameOffsets[other], nameOffsets[other + 1] - nameOffsets[other]})
+                    break;
+            }
+        }
+
+        Header header{};
+        std::memcpy(header.magic, imageMagic, sizeof(imageMagic));
+        header.version = MappedDefinition::version;
+        header.byteOrder = imageByteOrder;
+        header.stateCount = stateCount;
+        header.edgeCount = edges.size();
+        header.labelCount = labels.size();
+        header.aliasCount = aliasEdges.size();
+        header.idCount = ids.size();
+        header.nameBytes = names.size();
+        header.hashSize = hashSize;
+
+        std::uint64_t position = sizeof(Header);
+        auto place = [&position](std::uint64_t& section, std::uint64_t bytes) {
+            section = alignSection(position);
+            position = section + bytes;
+        };
+        place(header.edgeOffsets, edgeOffsets.size() * sizeof(std::uint32_t));
+        place(header.edges, edges.size() * sizeof(Edge));
+        place(header.labels, labels.size() * sizeof(Label));
+        place(header.aliasOffsets, aliasRows.size() * sizeof(std::uint32_t));
+        place(header.aliasEdges, aliasEdges.size() * sizeof(std::uint32_t));
+        place(header.aliasProbability, aliasProbability.size() * sizeof(double));
+        place(header.aliasColumns, aliasColumns.size() * sizeof(std::uint32_t));
+        place(header.nameOffsets, nameOffsets.size() * sizeof(std::uint32_t));
+        place(header.names, names.size());
+        place(header.nameHash, nameHash.size() * sizeof(std::uint32_t));
+        place(header.ids, ids.size() * sizeof(Id));
+        header.size = alignSection(position);
+
+        stream.write(reinterpret_cast <char const*> (&header), sizeof(Header));
+        position = sizeof(Header);
+        writeSection(stream, position, header.edgeOffsets, edgeOffsets);
+        writeSection(stream, position, header.edges, edges);
+        writeSection(stream, position, header.labels, labels);
+        writeSection(stream, position, header.aliasOffsets, aliasRows);
+        writeSection(stream, position, header.aliasEdges, aliasEdges);
+        writeSection(stream, position, header.aliasProbability, aliasProbability);
+        writeSection(stream, position, header.aliasColumns, aliasColumns);
+        writeSection(stream, position, header.nameOffsets, nameOffsets);
+        writeSection(stream, position, header.names, names);
+        writeSection(stream, position, header.nameHash, nameHash);
+        writeSection(stream, position, header.ids, ids);
+        writeSection(stream, position, header.size, std::vector <char> {});
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void saveDefinition(AutomatonDefinition const& definition, std::string const& path)
+    {
+        std::ofstream stream{path, std::ios_base::binary | std::ios_base::trunc};
+        if (!stream)
+            throw std::invalid_argument(("cannot open '"s + path + "' for writing").c_str());
+        saveDefinition(definition, stream);
+        stream.flush();
+        if (!stream)
+            throw std::invalid_argument(("cannot write the definition image to '"s + path + "'").c_str());
+    }
+//#####################################################################################################################
+    constexpr std::uint32_t MappedDefinition::version;
+//---------------------------------------------------------------------------------------------------------------------
+    MappedDefinition::MappedDefinition(std::string const& path)
+        : region_{}
+        , stateCount_{0}
+        , idCount_{0}
+        , hashMask_{0}
+        , edgeOffsets_{nullptr}
+        , edges_{nullptr}
+        , labels_{nullptr}
+        , aliasOffsets_{nullptr}
+        , aliasEdges_{nullptr}
+        , aliasProbability_{nullptr}
+        , aliasColumns_{nullptr}
+        , nameOffsets_{nullptr}
+        , names_{nullptr}
+        , nameHash_{nullptr}
+        , ids_{nullptr}
+    {
+        try
+        {
+            boost::interprocess::file_mapping file{path.c_str(), boost::interprocess::read_only};
+            region_.reset(new boost::interprocess::mapped_region{file, boost::interprocess::read_only});
+        }
+        catch (boost::interprocess::interprocess_exception const& exc)
+        {
+            throw std::invalid_argument(("cannot map '"s + path + "': " + exc.what()).c_str());
+        }
+        attach(static_cast <char const*> (region_->get_address()), region_->get_size());
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    MappedDefinition::MappedDefinition(void const* data, std::size_t size)
+        : region_{}
+        , stateCount_{0}
+        , idCount_{0}
+        , hashMask_{0}
+        , edgeOffsets_{nullptr}
+        , edges_{nullptr}
+        , labels_{nullptr}
+        , aliasOffsets_{nullptr}
+        , aliasEdges_{nullptr}
+        , aliasProbability_{nullptr}
+        , aliasColumns_{nullptr}
+        , nameOffsets_{nullptr}
+        , names_{nullptr}
+        , nameHash_{nullptr}
+        , ids_{nullptr}
+    {
+        attach(static_cast <char const*> (data), size);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    MappedDefinition::~MappedDefinition() = default;
+//---------------------------------------------------------------------------------------------------------------------
+    void MappedDefinition::attach(char const* data, std::size_t size)
+    {
+        if (size < sizeof(Header) || reinterpret_cast <std::uintptr_t> (data) % 8 != 0)
+            throw std::invalid_argument("not a definition image or not 8 byte aligned");
+
+        Header header;
+        std::memcpy(&header, data, sizeof(Header));
+        if (std::memcmp(header.magic, imageMagic, sizeof(imageMagic)) != 0)
+            throw std::invalid_argument("not a definition image");
+        if (header.byteOrder != imageByteOrder)
+            throw std::invalid_argument("definition image was written with a different byte order");
+        if (header.version != version)
+        {
+            throw std::invalid_argument((
+                "definition image has version "s + std::to_string(header.version) +
+                ", expected " + std::to_string(version)
+            ).c_str());
+        }
+
+        // counts are stored as 32 bit indices, which also keeps the section sizes below from overflowing.
+        auto limit = std::uint64_t{std::numeric_limits <std::uint32_t>::max()};
+        if (header.size > size || header.stateCount >= limit || header.edgeCount >= limit || header.labelCount >= limit ||
+            header.aliasCount >= limit || header.idCount >= limit || header.nameBytes >= limit ||
+            header.hashSize > 2 * limit || (header.hashSize & (header.hashSize - 1)) != 0 || header.hashSize <= header.stateCount)
+        {
+            throw std::invalid_argument("definition image is truncated or corrupt");
+        }
+
+        auto section = [&](std::uint64_t offset, std::uint64_t bytes) {
+            if (offset % 8 != 0 || offset < sizeof(Header) || offset > header.size || bytes > header.size - offset)
+                throw std::invalid_argument("definition image is truncated or corrupt");
+            return data + offset;
+        };
+        edgeOffsets_ = reinterpret_cast <std::uint32_t const*> (section(header.edgeOffsets, (header.stateCount + 1) * sizeof(std::uint32_t)));
+        edges_ = reinterpret_cast <Edge const*> (section(header.edges, header.edgeCount * sizeof(Edge)));
+        labels_ = reinterpret_cast <Label const*> (section(header.labels, header.labelCount * sizeof(Label)));
+        aliasOffsets_ = reinterpret_cast <std::uint32_t const*> (section(header.aliasOffsets, (header.stateCount + 1) * sizeof(std::uint32_t)));
+        aliasEdges_ = reinterpret_cast <std::uint32_t const*> (section(header.aliasEdges, header.aliasCount * sizeof(std::uint32_t)));
+        aliasProbability_ = reinterpret_cast <double const*> (section(header.aliasProbability, header.aliasCount * sizeof(double)));
+        aliasColumns_ = reinterpret_cast <std::uint32_t const*> (section(header.aliasColumns, header.aliasCount * sizeof(std::uint32_t)));
+        nameOffsets_ = reinterpret_cast <std::uint32_t const*> (section(header.nameOffsets, (header.stateCount + 1) * sizeof(std::uint32_t)));
+        names_ = section(header.names, header.nameBytes);
+        nameHash_ = reinterpret_cast <std::uint32_t const*> (section(header.nameHash, header.hashSize * sizeof(std::uint32_t)));
+        ids_ = reinterpret_cast <Id const*> (section(header.ids, header.idCount * sizeof(Id)));
+
+        // the contents are trusted beyond this, checking them would mean reading the whole image.
+        if (edgeOffsets_[header.stateCount] != header.edgeCount ||
+            aliasOffsets_[header.stateCount] != header.aliasCount ||
+            nameOffsets_[header.stateCount] != header.nameBytes)
+        {
+            throw std::invalid_argument("definition image is truncated or corrupt");
+        }
+
+        stateCount_ = static_cast <std::size_t> (header.stateCount);
+        idCount_ = static_cast <std::size_t> (header.idCount);
+        hashMask_ = static_cast <std::size_t> (header.hashSize - 1);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    AutomatonInstance MappedDefinition::makeInstance(std::uint64_t seed, std::size_t start) const
+    {
+        if (start >= stateCount_)
+            throw std::invalid_argument(("no such state with index '"s + std::to_string(start) + "' in definition").c_str());
+        return {static_cast <std::uint32_t> (start), seed};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t MappedDefinition::getIndex(StringView name) const
+    {
+        for (auto slot = static_cast <std::size_t> (hashName(name)) & hashMask_;; slot = (slot + 1) & hashMask_)
+        {
+            auto state = nameHash_[slot];
+            if (state == emptySlot)
+                break;
+            if (getName(state) == name)
+                return state;
+        }
+        throw std::invalid_argument(("no such state with name '"s + name.to_string() + "' in definition").c_str());
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t MappedDefinition::getIndex(int id) const
+    {
+        auto iter = std::lower_bound(ids_, ids_ + idCount_, id, [](Id const& lhs, int rhs) {
+            return lhs.id < rhs;
+        });
+        if (iter != ids_ + idCount_ && iter->id == id)
+            return iter->state;
+        else
+            throw std::invalid_argument(("no such state with id '"s + std::to_string(id) + "' in definition").c_str());
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    StringView MappedDefinition::getName(std::size_t index) const
+    {
+        return {names_ + nameOffsets_[index], nameOffsets_[index + 1] - nameOffsets_[index]};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t MappedDefinition::stateCount() const
+    {
+        return stateCount_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t MappedDefinition::edgeCount() const
+    {
+        return edgeOffsets_[stateCount_];
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool MappedDefinition::consume(AutomatonInstance& instance, std::uint8_t symbol) const
+    {
+        // weighted reservoir sampling over the active edges.
+        SplitMix64 generator{instance.random};
+        Edge const* chosen = nullptr;
+        double total = 0.;
+
+        auto end = edges_ + edgeOffsets_[instance.state + 1];
+        for (auto i = edges_ + edgeOffsets_[instance.state]; i != end; ++i)
+        {
+            if (i->label == noLabel || !((labels_[i->label].bits[symbol / 64] >> (symbol % 64)) & 1u))
+                continue;
+
+            total += i->weight;
+            if (chosen == nullptr || randomUnit(generator) * total < i->weight)
+                chosen = i;
+        }
+
+        if (chosen == nullptr)
+            return false;
+
+        instance.state = chosen->to;
+        return true;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool MappedDefinition::advance(AutomatonInstance& instance) const
+    {
+        auto first = aliasOffsets_[instance.state];
+        auto count = aliasOffsets_[instance.state + 1] - first;
+        if (count == 0)
+            return false;
+
+        SplitMix64 generator{instance.random};
+        auto position = count == 1 ? 0 : AliasTable::sample(aliasProbability_ + first, aliasColumns_ + first, count, generator);
+        instance.state = edges_[aliasEdges_[first + position]].to;
+        return true;
+    }
+//#####################################################################################################################
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "automata_fwd.hpp"
+#include "definition.hpp"
+#include "names.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+namespace boost
+{
+    namespace interprocess
+    {
+        class mapped_region;
+    }
+}
+
+namespace MiniAutomata
+{
+    /**
+     *  Writes the definition as a binary image that MappedDefinition can use without parsing:
+     *  state names and ids with their lookup tables, transitions, symbol labels, weights and alias tables.
+     *  Conditions and state actions are code and cannot be stored. Transitions with a condition
+     *  are refused with std::invalid_argument, state actions are left out.
+     *  The image is in native byte order.
+     */
+    void saveDefinition(AutomatonDefinition const& definition, std::ostream& stream);
+
+    /**
+     *  Writes the image to a file. Throws std::invalid_argument, if the file cannot be written.
+     */
+    void saveDefinition(AutomatonDefinition const& definition, std::string const& path);
+
+    /**
+     *  A read only definition stepped directly from an image written by saveDefinition.
+     *  Opening maps the file and checks the header, nothing is copied or allocated per state or transition,
+     *  so processes mapping the same file share its memory.
+     *  Stepping makes the same choices as the AutomatonDefinition the image was written from.
+     */
+    class MappedDefinition
+    {
+    public:
+        constexpr static std::uint32_t version = 1;
+
+    public:
+        /**
+         *  Maps the file read only. Throws std::invalid_argument, if it is not a valid image of this version.
+         */
+        explicit MappedDefinition(std::string const& path);
+
+        /**
+         *  Uses an image already in memory, which must be 8 byte aligned and outlive the definition.
+         *  Throws std::invalid_argument, if it is not a valid image of this version.
+         */
+        MappedDefinition(void const* data, std::size_t size);
+
+        ~MappedDefinition();
+
+        MappedDefinition(MappedDefinition const&) = delete;
+        MappedDefinition& operator=(MappedDefinition const&) = delete;
+
+        /**
+         *  Creates a new instance sitting at the given state.
+         */
+        AutomatonInstance makeInstance(std::uint64_t seed, std::size_t start = 0) const;
+
+        /**
+         *  Returns the state index for a state name.
+         */
+        std::size_t getIndex(StringView name) const;
+
+        /**
+         *  Returns the state index for a state id.
+         */
+        std::size_t getIndex(int id) const;
+
+        /**
+         *  Returns the name of the state at the given index.
+         */
+        StringView getName(std::size_t index) const;
+
+        /**
+         *  Returns the amount of states.
+         */
+        std::size_t stateCount() const;
+
+        /**
+         *  Returns the amount of transitions.
+         */
+        std::size_t edgeCount() const;
+
+        /**
+         *  Feeds one input symbol to the instance, see AutomatonDefinition::consume.
+         *
+         *  @return Returns true, if a transition has been made.
+         */
+        bool consume(AutomatonInstance& instance, std::uint8_t symbol) const;
+
+        /**
+         *  Transition to the next state, if possible, see AutomatonDefinition::advance.
+         *
+         *  @return Returns true, if a transition has been made.
+         */
+        bool advance(AutomatonInstance& instance) const;
+
+    private:
+        void attach(char const* data, std::size_t size);
+
+    private:
+        // The layout of the image. Sections are 8 byte aligned.
+        struct Edge
+        {
+            std::uint32_t to;
+            std::uint32_t label;
+            double weight;
+        };
+
+        struct Label
+        {
+            std::uint64_t bits[4];
+            std::uint64_t epsilon;
+        };
+
+        struct Id
+        {
+            std::int32_t id;
+            std::uint32_t state;
+        };
+
+        friend void saveDefinition(AutomatonDefinition const& definition, std::ostream& stream);
+
+    private:
+        std::unique_ptr <boost::interprocess::mapped_region> region_;
+
+        std::size_t stateCount_;
+        std::size_t idCount_;
+        std::size_t hashMask_;
+
+        // Outgoing edges of state i are edges_[edgeOffsets_[i], edgeOffsets_[i + 1]).
+        std::uint32_t const* edgeOffsets_;
+        Edge const* edges_;
+        Label const* labels_;
+
+        // Alias table row of state i covers aliasEdges_[aliasOffsets_[i], aliasOffsets_[i + 1]).
+        std::uint32_t const* aliasOffsets_;
+        std::uint32_t const* aliasEdges_;
+        double const* aliasProbability_;
+        std::uint32_t const* aliasColumns_;
+
+        // Name of state i is names_[nameOffsets_[i], nameOffsets_[i + 1]).
+        std::uint32_t const* nameOffsets_;
+        char const* names_;
+
+        // Open addressing by FNV-1a, holds state indices.
+        std::uint32_t const* nameHash_;
+
+        // Sorted by id.
+        Id const* ids_;
+    };
+}
@@ -0,0 +1,498 @@
+#include "markov.hpp"
+#include "definition.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace MiniAutomata
+{
+	using namespace std::string_literals;
+
+    namespace
+    {
+        // Below this amount of matrix entries per thread, synchronizing costs more than it saves.
+        constexpr std::size_t minEntriesPerThread = 1 << 14;
+
+        class Barrier
+        {
+        public:
+            explicit Barrier(std::size_t count)
+                : mutex_{}
+                , released_{}
+                , count_{count}
+                , waiting_{0}
+                , generation_{0}
+            {
+            }
+
+            void wait()
+            {
+                std::unique_lock <std::mutex> lock{mutex_};
+                auto generation = generation_;
+                if (++waiting_ == count_)
+                {
+                    waiting_ = 0;
+                    ++generation_;
+                    released_.notify_all();
+                    return;
+                }
+                released_.wait(lock, [&]() {return generation != generation_;});
+            }
+
+        private:
+            std::mutex mutex_;
+            std::condition_variable released_;
+            std::size_t count_;
+            std::size_t waiting_;
+            std::uint64_t generation_;
+        };
+
+        /**
+         *  Calls body(worker) on the calling thread and workers - 1 others and waits for all of them.
+         */
+        template <typename BodyT>
+        void runWorkers(std::size_t workers, BodyT const& body)
+        {
+            std::vector <std::thread> threads;
+            threads.reserve(workers - 1);
+            for (std::size_t worker = 1; worker < workers; ++worker)
+                threads.emplace_back(body, worker);
+            body(0);
+            for (auto& thread : threads)
+                thread.join();
+        }
+
+        /**
+         *  Runs step(parity, first, last) for the row ranges given by bounds, one worker per range,
+         *  until the largest residual returned by any worker is at most the tolerance.
+         *  Iteration i reads buffer i % 2 and writes the other, so no worker waits for more than one barrier.
+         */
+        template <typename StepT>
+        MarkovReport iterate(std::vector <std::size_t> const& bounds, std::size_t maxIterations, double tolerance, StepT const& step)
+        {
+            auto workers = bounds.size() - 1;
+            std::vector <double> residuals(2 * workers, 0.);
+            Barrier barrier{workers};
+            MarkovReport report{0, std::numeric_limits <double>::infinity(), false};
+
+            runWorkers(workers, [&](std::size_t worker) {
+                for (std::size_t iteration = 0; iteration != maxIterations; ++iteration)
+                {
+                    auto parity = iteration % 2;
+                    residuals[parity * workers + worker] = step(parity, bounds[worker], bounds[worker + 1]);
+                    barrier.wait();
+
+                    auto first = std::begin(residuals) + parity * workers;
+                    auto residual = *std::max_element(first, first + workers);
+                    if (worker == 0)
+                    {
+                        report.iterations = iteration + 1;
+                        report.residual = residual;
+                    }
+                    if (residual <= tolerance)
+                        return;
+                }
+            });
+
+            report.converged = report.residual <= tolerance;
+            return report;
+        }
+
+        /**
+         *  Per worker partial sums. Every worker adds them up in the same order, so all agree on the result.
+         */
+        class Reduction
+        {
+        public:
+            explicit Reduction(std::size_t workers)
+                : partials_(workers, 0.)
+            {
+            }
+
+            void set(std::size_t worker, double partial)
+            {
+                partials_[worker] = partial;
+            }
+
+            double sum() const
+            {
+                double result = 0.;
+                for (auto partial : partials_)
+                    result += partial;
+                return result;
+            }
+
+        private:
+            std::vector <double> partials_;
+        };
+    }
+//#####################################################################################################################
+    MarkovChain::MarkovChain(AutomatonDefinition const& definition, std::size_t threadCount)
+        : threadCount_{std::max <std::size_t> (threadCount, 1)}
+        , offsets_(definition.stateCount() + 1, 0)
+        , targets_{}
+        , probabilities_{}
+        , incomingOffsets_(definition.stateCount() + 1, 0)
+        , sources_{}
+        , incomingProbabilities_{}
+    {
+        auto stateCount = definition.stateCount();
+        for (std::size_t state = 0; state != stateCount; ++state)
+        {
+            offsets_[state] = targets_.size();
+
+            double total = 0.;
+            for (auto i = definition.edgesBegin(state); i != definition.edgesEnd(state); ++i)
+            {
+                if (i->symbols)
+                    continue;
+                if (!i->trigger.isUnconditional())
+                    throw std::invalid_argument("guarded transitions have no fixed probability");
+                total += i->weight;
+            }
+
+            if (total == 0.)
+            {
+                // absorbing.
+                targets_.push_back(state);
+                probabilities_.push_back(1.);
+                continue;
+            }
+
+            for (auto i = definition.edgesBegin(state); i != definition.edgesEnd(state); ++i)
+            {
+                if (i->symbols)
+                    continue;
+                targets_.push_back(i->to);
+                probabilities_.push_back(i->weight / total);
+            }
+        }
+        offsets_[stateCount] = targets_.size();
+
+        // transpose by counting entries per column.
+        for (auto to : targets_)
+            ++incomingOffsets_[to + 1];
+        for (std::size_t state = 0; state != stateCount; ++state)
+            incomingOffsets_[state + 1] += incomingOffsets_[state];
+
+        sources_.resize(targets_.size());
+        incomingProbabilities_.resize(targets_.size());
+        std::vector <std::size_t> fill(std::begin(incomingOffsets_), std::end(incomingOffsets_) - 1);
+        for (std::size_t from = 0; from != stateCount; ++from)
+        {
+            for (auto i = offsets_[from]; i != offsets_[from + 1]; ++i)
+            {
+                auto position = fill[targets_[i]]++;
+                sources_[position] = from;
+                incomingProbabilities_[position] = probabilities_[i];
+            }
+        }
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t MarkovChain::stateCount() const
+    {
+        return offsets_.size() - 1;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    double MarkovChain::probability(std::size_t from, std::size_t to) const
+    {
+        if (from >= stateCount())
+            throw std::invalid_argument(("no such state with index '"s + std::to_string(from) + "' in markov chain").c_str());
+
+        double result = 0.;
+        for (auto i = offsets_[from]; i != offsets_[from + 1]; ++i)
+            if (targets_[i] == to)
+                result += probabilities_[i];
+        return result;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::vector <std::size_t> MarkovChain::partition(std::vector <std::size_t> const& offsets) const
+    {
+        auto rows = offsets.size() - 1;
+        auto entries = offsets.back();
+        auto workers = std::min(threadCount_, std::max <std::size_t> (entries / minEntriesPerThread, 1));
+
+        std::vector <std::size_t> bounds(1, 0);
+        for (std::size_t worker = 1; worker < workers; ++worker)
+        {
+            auto row = static_cast <std::size_t> (
+                std::lower_bound(std::begin(offsets), std::end(offsets) - 1, entries * worker / workers) - std::begin(offsets)
+            );
+            bounds.push_back(std::max(row, bounds.back()));
+        }
+        bounds.push_back(rows);
+        return bounds;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::vector <double> MarkovChain::distribution(std::vector <double> const& initial, std::size_t steps) const
+    {
+        if (initial.size() != stateCount())
+            throw std::invalid_argument("initial distribution needs one entry per state");
+
+        std::vector <double> buffers[2] = {initial, std::vector <double> (initial.size(), 0.)};
+        if (steps == 0)
+            return initial;
+
+        iterate(partition(incomingOffsets_), steps, -1., [&](std::size_t parity, std::size_t first, std::size_t last) {
+            auto const& in = buffers[parity];
+            auto& out = buffers[1 - parity];
+            for (auto to = first; to != last; ++to)
+            {
+                double sum = 0.;
+                for (auto i = incomingOffsets_[to]; i != incomingOffsets_[to + 1]; ++i)
+                    sum += incomingProbabilities_[i] * in[sources_[i]];
+                out[to] = sum;
+            }
+            return 0.;
+        });
+        return std::move(buffers[steps % 2]);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::vector <double> MarkovChain::distribution(std::size_t start, std::size_t steps) const
+    {
+        if (start >= stateCount())
+            throw std::invalid_argument(("no such state with index '"s + std::to_string(start) + "' in markov chain").c_str());
+
+        std::vector <double> initial(stateCount(), 0.);
+        initial[start] = 1.;
+        return distribution(initial, steps);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::vector <double> MarkovChain::stationaryDistribution(MarkovReport& report, double tolerance, std::size_t maxIterations) const
+    {
+        auto count = stateCount();
+        if (count == 0)
+        {
+            report = MarkovReport{0, 0., true};
+            return {};
+        }
+
+        std::vector <double> buffers[2] = {
+            std::vector <double> (count, 1. / static_cast <double> (count)),
+            std::vector <double> (count, 0.)
+        };
+
+        report = iterate(partition(incomingOffsets_), maxIterations, tolerance, [&](std::size_t parity, std::size_t first, std::size_t last) {
+            auto const& in = buffers[parity];
+            auto& out = buffers[1 - parity];
+            double residual = 0.;
+            for (auto to = first; to != last; ++to)
+            {
+                double sum = 0.;
+                for (auto i = incomingOffsets_[to]; i != incomingOffsets_[to + 1]; ++i)
+                    sum += incomingProbabilities_[i] * in[sources_[i]];
+                out[to] = 0.5 * in[to] + 0.5 * sum;
+                residual = std::max(residual, std::abs(out[to] - in[to]));
+            }
+            return residual;
+        });
+
+        auto result = std::move(buffers[report.iterations % 2]);
+
+        // remove the drift rounding errors accumulated over the iterations.
+        double total = 0.;
+        for (auto p : result)
+            total += p;
+        for (auto& p : result)
+            p /= total;
+        return result;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::vector <double> MarkovChain::stationaryDistribution() const
+    {
+        MarkovReport report;
+        return stationaryDistribution(report);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::vector <double> MarkovChain::hittingTimes(
+        std::vector <std::size_t> const& targets,
+        MarkovReport& report,
+        double tolerance,
+        std::size_t maxIterations
+    ) const
+    {
+        auto count = stateCount();
+        auto infinity = std::numeric_limits <double>::infinity();
+
+        std::vector <bool> isTarget(count, false);
+        for (auto target : targets)
+        {
+            if (target >= count)
+                throw std::invalid_argument(("no such state with index '"s + std::to_string(target) + "' in markov chain").c_str());
+            isTarget[target] = true;
+        }
+
+        // states that can reach a target at all, by backward search from the targets.
+        std::vector <bool> reaches(isTarget);
+        std::vector <std::size_t> pending(targets);
+        while (!pending.empty())
+        {
+            auto state = pending.back();
+            pending.pop_back();
+            for (auto i = incomingOffsets_[state]; i != incomingOffsets_[state + 1]; ++i)
+            {
+                if (!reaches[sources_[i]])
+                {
+                    reaches[sources_[i]] = true;
+                    pending.push_back(sources_[i]);
+                }
+            }
+        }
+
+        // states that may end up where no target is reachable take infinitely long on average.
+        std::vector <bool> infinite(count, false);
+        for (std::size_t state = 0; state != count; ++state)
+        {
+            if (!reaches[state])
+            {
+                infinite[state] = true;
+                pending.push_back(state);
+            }
+        }
+        while (!pending.empty())
+        {
+            auto state = pending.back();
+            pending.pop_back();
+            for (auto i = incomingOffsets_[state]; i != incomingOffsets_[state + 1]; ++i)
+            {
+                auto source = sources_[i];
+                if (!infinite[source] && !isTarget[source])
+                {
+                    infinite[source] = true;
+                    pending.push_back(source);
+                }
+            }
+        }
+
+        // the remaining states solve (I - Q) h = 1, Q being the transitions among them. Other rows are
+        // identity rows with h = 0, which no remaining state refers to. Solved by BiCGSTAB with the diagonal
+        // as preconditioner, where every worker owns a range of rows and scalars are reduced at barriers.
+        std::vector <bool> solved(count, false);
+        std::vector <double> diagonal(count, 1.);
+        for (std::size_t state = 0; state != count; ++state)
+        {
+            solved[state] = !isTarget[state] && !infinite[state];
+            if (solved[state])
+                diagonal[state] = 1. - probability(state, state);
+        }
+
+        std::vector <double> x(count, 0.), r(count, 0.), rHat(count, 0.), p(count, 0.), v(count, 0.);
+        std::vector <double> y(count, 0.), sVector(count, 0.), z(count, 0.), t(count, 0.);
+        for (std::size_t state = 0; state != count; ++state)
+            r[state] = rHat[state] = solved[state] ? 1. : 0.;
+
+        auto norm = std::sqrt(static_cast <double> (std::count(std::begin(solved), std::end(solved), true)));
+        auto bounds = partition(offsets_);
+        auto workers = bounds.size() - 1;
+        Barrier barrier{workers};
+        Reduction rhoSum{workers}, rHatVSum{workers}, tsSum{workers}, ttSum{workers}, rrSum{workers};
+        report = MarkovReport{0, norm == 0. ? 0. : 1., norm == 0.};
+
+        auto multiply = [&](std::vector <double> const& in, std::vector <double>& out, std::size_t first, std::size_t last) {
+            for (auto from = first; from != last; ++from)
+            {
+                double sum = in[from];
+                if (solved[from])
+                    for (auto i = offsets_[from]; i != offsets_[from + 1]; ++i)
+                        sum -= probabilities_[i] * in[targets_[i]];
+                out[from] = sum;
+            }
+        };
+
+        runWorkers(workers, [&](std::size_t worker) {
+            auto first = bounds[worker];
+            auto last = bounds[worker + 1];
+
+            double partial = 0.;
+            for (auto i = first; i != last; ++i)
+                partial += rHat[i] * r[i];
+            rhoSum.set(worker, partial);
+            barrier.wait();
+
+            double rho = 1., alpha = 1., omega = 1.;
+            for (std::size_t iteration = 0; iteration != maxIterations && norm != 0.; ++iteration)
+            {
+                auto rhoNext = rhoSum.sum();
+                if (rhoNext == 0.)
+                    return;
+                auto beta = (rhoNext / rho) * (alpha / omega);
+                rho = rhoNext;
+
+                for (auto i = first; i != last; ++i)
+                {
+                    p[i] = r[i] + beta * (p[i] - omega * v[i]);
+                    y[i] = p[i] / diagonal[i];
+                }
+                barrier.wait();
+
+                multiply(y, v, first, last);
+                partial = 0.;
+                for (auto i = first; i != last; ++i)
+                    partial += rHat[i] * v[i];
+                rHatVSum.set(worker, partial);
+                barrier.wait();
+
+                auto rHatV = rHatVSum.sum();
+                if (rHatV == 0.)
+                    return;
+                alpha = rho / rHatV;
+                for (auto i = first; i != last; ++i)
+                {
+                    sVector[i] = r[i] - alpha * v[i];
+                    z[i] = sVector[i] / diagonal[i];
+                }
+                barrier.wait();
+
+                multiply(z, t, first, last);
+                double ts = 0., tt = 0.;
+                for (auto i = first; i != last; ++i)
+                {
+                    ts += t[i] * sVector[i];
+                    tt += t[i] * t[i];
+                }
+                tsSum.set(worker, ts);
+                ttSum.set(worker, tt);
+                barrier.wait();
+
+                auto ttTotal = ttSum.sum();
+                omega = ttTotal == 0. ? 0. : tsSum.sum() / ttTotal;
+                double rr = 0.;
+                partial = 0.;
+                for (auto i = first; i != last; ++i)
+                {
+                    x[i] += alpha * y[i] + omega * z[i];
+                    r[i] = sVector[i] - omega * t[i];
+                    rr += r[i] * r[i];
+                    partial += rHat[i] * r[i];
+                }
+                rrSum.set(worker, rr);
+                rhoSum.set(worker, partial);
+                barrier.wait();
+
+                auto residual = std::sqrt(rrSum.sum()) / norm;
+                if (worker == 0)
+                    report = MarkovReport{iteration + 1, residual, residual <= tolerance};
+                if (residual <= tolerance || omega == 0.)
+                    return;
+            }
+        });
+
+        for (std::size_t state = 0; state != count; ++state)
+            if (infinite[state])
+                x[state] = infinity;
+        return x;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::vector <double> MarkovChain::hittingTimes(std::vector <std::size_t> const& targets) const
+    {
+        MarkovReport report;
+        return hittingTimes(targets, report);
+    }
+//#####################################################################################################################
+}
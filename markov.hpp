@@ -0,0 +1,114 @@
+#pragma once
+
+#include "automata_fwd.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace MiniAutomata
+{
+    /**
+     *  How an iterative computation of a MarkovChain ended.
+     */
+    struct MarkovReport
+    {
+        std::size_t iterations;
+
+        // Largest change of a probability in the last iteration,
+        // or the norm of the residual relative to the right hand side for hitting times.
+        double residual;
+        bool converged;
+    };
+
+    /**
+     *  The transitions without symbols of a definition read as a discrete time Markov chain.
+     *  The probability of a transition is its weight divided by the sum of weights of its state.
+     *  States without such transitions are absorbing. Transitions are stored as sparse matrices
+     *  in both directions. All computations iterate sparse matrix vector products, split by rows
+     *  over threads for large chains.
+     */
+    class MarkovChain
+    {
+    public:
+        /**
+         *  Guarded transitions are rejected with std::invalid_argument, they have no fixed probability.
+         *
+         *  @param threadCount The amount of threads iterations may use, including the calling thread.
+         */
+        explicit MarkovChain(AutomatonDefinition const& definition, std::size_t threadCount = 1);
+
+        /**
+         *  Returns the amount of states.
+         */
+        std::size_t stateCount() const;
+
+        /**
+         *  Returns the probability to move from one state to the other in one step.
+         */
+        double probability(std::size_t from, std::size_t to) const;
+
+        /**
+         *  Returns the distribution over states after the given amount of steps.
+         *
+         *  @param initial The distribution at step 0, one entry per state.
+         */
+        std::vector <double> distribution(std::vector <double> const& initial, std::size_t steps) const;
+
+        /**
+         *  Returns the distribution over states after the given amount of steps from a start state.
+         */
+        std::vector <double> distribution(std::size_t start, std::size_t steps) const;
+
+        /**
+         *  Returns the long run distribution, starting from the uniform distribution.
+         *  Iterates the lazy chain (stay with probability 1/2), which has the same stationary distribution
+         *  but also converges for periodic chains. For chains that are not irreducible the result
+         *  depends on the uniform start.
+         */
+        std::vector <double> stationaryDistribution(
+            MarkovReport& report,
+            double tolerance = 1e-12,
+            std::size_t maxIterations = 1 << 20
+        ) const;
+
+        /**
+         *  Returns the long run distribution, starting from the uniform distribution.
+         */
+        std::vector <double> stationaryDistribution() const;
+
+        /**
+         *  Returns the expected amount of steps from every state until one of the targets is reached.
+         *  The entry is infinity for states that reach no target with probability 1.
+         *  The linear system for the other states is solved by BiCGSTAB, which needs far fewer
+         *  iterations than stepping the expectations forward when hitting times are long.
+         */
+        std::vector <double> hittingTimes(
+            std::vector <std::size_t> const& targets,
+            MarkovReport& report,
+            double tolerance = 1e-12,
+            std::size_t maxIterations = 1 << 20
+        ) const;
+
+        /**
+         *  Returns the expected amount of steps from every state until one of the targets is reached.
+         */
+        std::vector <double> hittingTimes(std::vector <std::size_t> const& targets) const;
+
+    private:
+        // Splits rows into one range per worker with about the same amount of entries.
+        std::vector <std::size_t> partition(std::vector <std::size_t> const& offsets) const;
+
+    private:
+        std::size_t threadCount_;
+
+        // Row i holds the transitions out of state i: targets_[offsets_[i], offsets_[i + 1]).
+        std::vector <std::size_t> offsets_;
+        std::vector <std::size_t> targets_;
+        std::vector <double> probabilities_;
+
+        // The transposed matrix, row i holds the transitions into state i.
+        std::vector <std::size_t> incomingOffsets_;
+        std::vector <std::size_t> sources_;
+        std::vector <double> incomingProbabilities_;
+    };
+}
@@ -0,0 +1,65 @@
+#include "names.hpp"
+
+#include <boost/functional/hash.hpp>
+
+namespace MiniAutomata
+{
+//#####################################################################################################################
+    std::size_t NameTable::Hash::operator()(StringView name) const
+    {
+        return boost::hash_range(name.begin(), name.end());
+    }
+//#####################################################################################################################
+    NameTable::NameTable()
+        : names_{}
+        , indices_{}
+    {
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    NameTable::NameTable(NameTable const& other)
+        : names_{other.names_}
+        , indices_{}
+    {
+        indices_.reserve(names_.size());
+        for (std::size_t i = 0; i != names_.size(); ++i)
+            indices_.emplace(StringView{names_[i]}, other.indices_.find(StringView{other.names_[i]})->second);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    NameTable& NameTable::operator=(NameTable const& other)
+    {
+        if (this != &other)
+            *this = NameTable{other};
+        return *this;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    StringView NameTable::intern(StringView name, std::size_t index)
+    {
+        auto iter = indices_.find(name);
+        if (iter != std::end(indices_))
+            return iter->first;
+
+        names_.emplace_back(name.data(), name.size());
+        StringView stored{names_.back()};
+        indices_.emplace(stored, index);
+        return stored;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void NameTable::reserve(std::size_t count)
+    {
+        indices_.reserve(count);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    boost::optional <std::size_t> NameTable::find(StringView name) const
+    {
+        auto iter = indices_.find(name);
+        if (iter == std::end(indices_))
+            return boost::none;
+        return iter->second;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t NameTable::size() const
+    {
+        return names_.size();
+    }
+//#####################################################################################################################
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#include <boost/optional.hpp>
+#include <boost/utility/string_view.hpp>
+
+namespace MiniAutomata
+{
+    using StringView = boost::string_view;
+
+    /**
+     *  Maps names to indices and owns the names of the states added to an automaton, states only refer to them.
+     *  Looking one up takes a string view, so lookups from literals do not allocate.
+     */
+    class NameTable
+    {
+    public:
+        NameTable();
+
+        /**
+         *  Copies rebuild the lookup to refer to their own names.
+         */
+        NameTable(NameTable const& other);
+        NameTable(NameTable&& other) = default;
+        NameTable& operator=(NameTable const& other);
+        NameTable& operator=(NameTable&& other) = default;
+
+        /**
+         *  Adds the name with its index, unless the name is already present.
+         *
+         *  @return Returns the name as stored in the table. It stays valid as long as the table, moves included.
+         */
+        StringView intern(StringView name, std::size_t index);
+
+        /**
+         *  Reserves memory for the given amount of names.
+         */
+        void reserve(std::size_t count);
+
+        /**
+         *  Returns the index for the name.
+         */
+        boost::optional <std::size_t> find(StringView name) const;
+
+        /**
+         *  Returns the amount of names.
+         */
+        std::size_t size() const;
+
+    private:
+        struct Hash
+        {
+            std::size_t operator()(StringView name) const;
+        };
+
+    private:
+        // A deque never moves its elements, so views into them stay valid.
+        std::deque <std::string> names_;
+        std::unordered_map <StringView, std::size_t, Hash> indices_;
+    };
+}
@@ -0,0 +1,160 @@
+#include "nfa.hpp"
+#include "definition.hpp"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+namespace MiniAutomata
+{
+	using namespace std::string_literals;
+//#####################################################################################################################
+    std::size_t Nfa::StateSetHash::operator()(StateSet const& states) const
+    {
+        std::size_t hash = states.size();
+        for (auto state : states)
+            hash ^= std::hash <std::uint32_t>{}(state) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        return hash;
+    }
+//#####################################################################################################################
+    Nfa::Nfa(AutomatonDefinition const& definition, std::size_t start)
+        : classes_{}
+        , accepting_(definition.stateCount(), false)
+        , closureOffsets_(definition.stateCount() + 1, 0)
+        , closures_{}
+        , moveOffsets_(definition.stateCount() + 1, 0)
+        , moves_{}
+        , startSet_{}
+    {
+        auto stateCount = definition.stateCount();
+        if (start >= stateCount)
+            throw std::invalid_argument(("no such state with index '"s + std::to_string(start) + "' in definition").c_str());
+
+        for (std::size_t state = 0; state != stateCount; ++state)
+        {
+            accepting_[state] = definition.getState(state).isAccepting();
+            for (auto i = definition.edgesBegin(state); i != definition.edgesEnd(state); ++i)
+            {
+                if (!i->symbols)
+                    continue;
+                if (!i->trigger.isUnconditional())
+                    throw std::invalid_argument("guarded symbol transitions cannot be determinized");
+                if (!i->symbols->isEpsilon())
+                    classes_.split(i->symbols->bits());
+            }
+        }
+
+        std::array <std::uint8_t, 256> representatives;
+        for (std::size_t c = 0; c != classes_.count(); ++c)
+            representatives[c] = classes_.representative(c);
+
+        // symbol moves per byte class.
+        for (std::size_t state = 0; state != stateCount; ++state)
+        {
+            moveOffsets_[state] = moves_.size();
+            for (auto i = definition.edgesBegin(state); i != definition.edgesEnd(state); ++i)
+            {
+                if (!i->symbols || i->symbols->isEpsilon())
+                    continue;
+                for (std::size_t c = 0; c != classes_.count(); ++c)
+                    if (i->symbols->contains(representatives[c]))
+                        moves_.push_back({static_cast <std::uint32_t> (c), static_cast <std::uint32_t> (i->to)});
+            }
+            std::sort(std::begin(moves_) + moveOffsets_[state], std::end(moves_), [](Move const& lhs, Move const& rhs) {
+                return lhs.byteClass < rhs.byteClass || (lhs.byteClass == rhs.byteClass && lhs.to < rhs.to);
+            });
+        }
+        moveOffsets_[stateCount] = moves_.size();
+
+        // epsilon closures by depth first search, visited marks are stamped with the origin state.
+        std::vector <std::size_t> visited(stateCount, stateCount);
+        std::vector <std::uint32_t> pending;
+        for (std::size_t state = 0; state != stateCount; ++state)
+        {
+            closureOffsets_[state] = closures_.size();
+            pending.push_back(static_cast <std::uint32_t> (state));
+            visited[state] = state;
+            while (!pending.empty())
+            {
+                auto current = pending.back();
+                pending.pop_back();
+                closures_.push_back(current);
+                for (auto i = definition.edgesBegin(current); i != definition.edgesEnd(current); ++i)
+                {
+                    if (i->symbols && i->symbols->isEpsilon() && visited[i->to] != state)
+                    {
+                        visited[i->to] = state;
+                        pending.push_back(static_cast <std::uint32_t> (i->to));
+                    }
+                }
+            }
+            std::sort(std::begin(closures_) + closureOffsets_[state], std::end(closures_));
+        }
+        closureOffsets_[stateCount] = closures_.size();
+
+        startSet_.assign(
+            std::begin(closures_) + closureOffsets_[start],
+            std::begin(closures_) + closureOffsets_[start + 1]
+        );
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t Nfa::stateCount() const
+    {
+        return accepting_.size();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    ByteClasses const& Nfa::getByteClasses() const
+    {
+        return classes_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Nfa::StateSet const& Nfa::getStartSet() const
+    {
+        return startSet_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Nfa::isAccepting(StateSet const& states) const
+    {
+        return std::any_of(std::begin(states), std::end(states), [this](std::uint32_t state) {
+            return accepting_[state];
+        });
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Nfa::step(StateSet const& from, std::size_t byteClass, StateSet& result) const
+    {
+        result.clear();
+        for (auto state : from)
+        {
+            auto first = std::begin(moves_) + moveOffsets_[state];
+            auto last = std::begin(moves_) + moveOffsets_[state + 1];
+            auto iter = std::lower_bound(first, last, byteClass, [](Move const& move, std::size_t c) {
+                return move.byteClass < c;
+            });
+            for (; iter != last && iter->byteClass == byteClass; ++iter)
+            {
+                result.insert(
+                    std::end(result),
+                    std::begin(closures_) + closureOffsets_[iter->to],
+                    std::begin(closures_) + closureOffsets_[iter->to + 1]
+                );
+            }
+        }
+        std::sort(std::begin(result), std::end(result));
+        result.erase(std::unique(std::begin(result), std::end(result)), std::end(result));
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t Nfa::memoryUsage() const
+    {
+        return
+            accepting_.size() / 8 +
+            closureOffsets_.capacity() * sizeof(std::size_t) +
+            closures_.capacity() * sizeof(std::uint32_t) +
+            moveOffsets_.capacity() * sizeof(std::size_t) +
+            moves_.capacity() * sizeof(Move) +
+            startSet_.capacity() * sizeof(std::uint32_t)
+        ;
+    }
+//#####################################################################################################################
+}
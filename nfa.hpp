@@ -0,0 +1,90 @@
+#pragma once
+
+#include "automata_fwd.hpp"
+#include "symbols.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MiniAutomata
+{
+    /**
+     *  The symbol labeled transitions of a definition as a nondeterministic automaton over byte classes.
+     *  Epsilon closures of all states are precomputed. Sets of states are sorted vectors of state indices.
+     */
+    class Nfa
+    {
+    public:
+        using StateSet = std::vector <std::uint32_t>;
+
+        /**
+         *  Hash for sets of states, to find subsets already seen.
+         */
+        struct StateSetHash
+        {
+            std::size_t operator()(StateSet const& states) const;
+        };
+
+    public:
+        /**
+         *  Transitions without symbols are ignored, guarded symbol transitions are rejected with std::invalid_argument.
+         */
+        explicit Nfa(AutomatonDefinition const& definition, std::size_t start = 0);
+
+        /**
+         *  Returns the amount of states.
+         */
+        std::size_t stateCount() const;
+
+        /**
+         *  Returns the byte classes no transition label tells apart.
+         */
+        ByteClasses const& getByteClasses() const;
+
+        /**
+         *  Returns the epsilon closure of the start state.
+         */
+        StateSet const& getStartSet() const;
+
+        /**
+         *  Returns true, if any state of the set is accepting.
+         */
+        bool isAccepting(StateSet const& states) const;
+
+        /**
+         *  Computes the epsilon closed set of states reached from the given set with a symbol of the byte class.
+         *
+         *  @param from A sorted and epsilon closed set of states.
+         *  @param byteClass The byte class of the consumed symbol.
+         *  @param result Receives the sorted result.
+         */
+        void step(StateSet const& from, std::size_t byteClass, StateSet& result) const;
+
+        /**
+         *  Returns an estimate of the memory held by this automaton in bytes.
+         */
+        std::size_t memoryUsage() const;
+
+    private:
+        struct Move
+        {
+            std::uint32_t byteClass;
+            std::uint32_t to;
+        };
+
+    private:
+        ByteClasses classes_;
+        std::vector <bool> accepting_;
+
+        // Epsilon closure of state i is closures_[closureOffsets_[i], closureOffsets_[i + 1]).
+        std::vector <std::size_t> closureOffsets_;
+        std::vector <std::uint32_t> closures_;
+
+        // Symbol moves of state i, sorted by byte class, are moves_[moveOffsets_[i], moveOffsets_[i + 1]).
+        std::vector <std::size_t> moveOffsets_;
+        std::vector <Move> moves_;
+
+        StateSet startSet_;
+    };
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace MiniAutomata
+{
+    /**
+     *  A set of pointers to active and selectable elements (transitions or edges).
+     *  Up to InlineCapacity pointers are stored without touching the heap. A set that once
+     *  grew beyond that keeps its spill capacity when cleared, so a reused set stops allocating.
+     */
+    template <typename T, std::size_t InlineCapacity = 8>
+    class PointerSet
+    {
+    public:
+        constexpr static std::size_t inlineCapacity = InlineCapacity;
+
+        using iterator = T**;
+        using const_iterator = T* const*;
+
+    public:
+        PointerSet()
+            : size_{0}
+            , inline_{}
+            , spill_{}
+        {
+        }
+
+        void insert(T* element)
+        {
+            if (size_ < InlineCapacity)
+            {
+                inline_[size_++] = element;
+                return;
+            }
+
+            if (size_ == InlineCapacity)
+                spill_.assign(std::begin(inline_), std::end(inline_));
+            spill_.push_back(element);
+            ++size_;
+        }
+
+        void clear()
+        {
+            size_ = 0;
+            spill_.clear();
+        }
+
+        iterator begin()
+        {
+            return spilled() ? spill_.data() : inline_.data();
+        }
+
+        iterator end()
+        {
+            return begin() + size_;
+        }
+
+        const_iterator begin() const
+        {
+            return cbegin();
+        }
+
+        const_iterator end() const
+        {
+            return cend();
+        }
+
+        const_iterator cbegin() const
+        {
+            return spilled() ? spill_.data() : inline_.data();
+        }
+
+        const_iterator cend() const
+        {
+            return cbegin() + size_;
+        }
+
+        T* first()
+        {
+            return *begin();
+        }
+
+        bool empty() const
+        {
+            return size_ == 0;
+        }
+
+        std::size_t size() const
+        {
+            return size_;
+        }
+
+    private:
+        bool spilled() const
+        {
+            return size_ > InlineCapacity;
+        }
+
+    private:
+        std::size_t size_;
+        std::array <T*, InlineCapacity> inline_;
+        std::vector <T*> spill_;
+    };
+}
@@ -0,0 +1,114 @@
+#include "predicate.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+namespace MiniAutomata
+{
+	using namespace std::string_literals;
+
+    namespace
+    {
+        struct CacheSlot
+        {
+            std::uint64_t epoch;
+            bool result;
+        };
+
+        // Results are cached per thread, so that parallel runners need no synchronization.
+        // Slots are indexed by predicate id, epoch 0 is never current.
+        struct EpochCache
+        {
+            std::uint64_t epoch;
+            std::vector <CacheSlot> slots;
+        };
+
+        thread_local EpochCache epochCache{1, {}};
+        std::atomic <std::size_t> nextPredicateId{0};
+    }
+//#####################################################################################################################
+    SharedPredicate::SharedPredicate(std::function <bool()> const& condition)
+        : shared_{std::make_shared <Shared>()}
+    {
+        if (!condition)
+            throw std::invalid_argument("shared predicate requires a condition");
+
+        shared_->condition = condition;
+        shared_->id = nextPredicateId.fetch_add(1, std::memory_order_relaxed);
+        shared_->evaluations.store(0, std::memory_order_relaxed);
+        shared_->savedEvaluations.store(0, std::memory_order_relaxed);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool SharedPredicate::operator()() const
+    {
+        auto& cache = epochCache;
+        auto id = shared_->id;
+        if (id >= cache.slots.size())
+            cache.slots.resize(id + 1, CacheSlot{0, false});
+
+        if (cache.slots[id].epoch == cache.epoch)
+        {
+            shared_->savedEvaluations.fetch_add(1, std::memory_order_relaxed);
+            return cache.slots[id].result;
+        }
+
+        // the condition may use other shared predicates, which can resize the slots.
+        auto epoch = cache.epoch;
+        bool result = shared_->condition();
+        cache.slots[id] = CacheSlot{epoch, result};
+        shared_->evaluations.fetch_add(1, std::memory_order_relaxed);
+        return result;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t SharedPredicate::getId() const
+    {
+        return shared_->id;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    SharedPredicate::Statistics SharedPredicate::getStatistics() const
+    {
+        return {
+            shared_->evaluations.load(std::memory_order_relaxed),
+            shared_->savedEvaluations.load(std::memory_order_relaxed)
+        };
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void SharedPredicate::beginEpoch()
+    {
+        ++epochCache.epoch;
+    }
+//#####################################################################################################################
+    SharedPredicate const& PredicateRegistry::add(std::string const& name, std::function <bool()> const& condition)
+    {
+        auto result = predicates_.emplace(name, SharedPredicate{condition});
+        if (!result.second)
+            throw std::invalid_argument(("predicate with name '"s + name + "' already exists").c_str());
+        return result.first->second;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    SharedPredicate const& PredicateRegistry::operator[](std::string const& name) const
+    {
+        auto iter = predicates_.find(name);
+        if (iter == std::end(predicates_))
+            throw std::invalid_argument(("no such predicate with name '"s + name + "'").c_str());
+        return iter->second;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t PredicateRegistry::size() const
+    {
+        return predicates_.size();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    SharedPredicate::Statistics PredicateRegistry::getStatistics() const
+    {
+        SharedPredicate::Statistics result{0, 0};
+        for (auto const& predicate : predicates_)
+        {
+            auto statistics = predicate.second.getStatistics();
+            result.evaluations += statistics.evaluations;
+            result.savedEvaluations += statistics.savedEvaluations;
+        }
+        return result;
+    }
+//#####################################################################################################################
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace MiniAutomata
+{
+    /**
+     *  A condition shared between many transitions, that is evaluated at most once per epoch and thread.
+     *  Further calls within the same epoch return the cached result. An epoch is one step of an automaton,
+     *  or one call of AutomatonBatch::advance for all instances it steps.
+     *  Copies share the cache and the statistics. Use it as a trigger condition: Trigger{predicate}.
+     */
+    class SharedPredicate
+    {
+    public:
+        struct Statistics
+        {
+            std::uint64_t evaluations;
+            std::uint64_t savedEvaluations;
+        };
+
+    public:
+        explicit SharedPredicate(std::function <bool()> const& condition);
+
+        /**
+         *  Returns the result of the condition, evaluating it only if it was not yet evaluated in the current epoch.
+         */
+        bool operator()() const;
+
+        /**
+         *  Returns the process wide unique id of this predicate.
+         */
+        std::size_t getId() const;
+
+        /**
+         *  Returns how often the condition was called and how many calls were answered from the cache instead.
+         */
+        Statistics getStatistics() const;
+
+        /**
+         *  Starts a new epoch on the calling thread, which invalidates all cached results of this thread.
+         *  Automaton and AutomatonBatch do this on every step. Callers stepping definitions directly
+         *  decide themselves how long results may be reused.
+         */
+        static void beginEpoch();
+
+    private:
+        struct Shared
+        {
+            std::function <bool()> condition;
+            std::size_t id;
+            std::atomic <std::uint64_t> evaluations;
+            std::atomic <std::uint64_t> savedEvaluations;
+        };
+
+    private:
+        std::shared_ptr <Shared> shared_;
+    };
+
+    /**
+     *  Predicates registered by name, so that transitions declared in different places use the same one.
+     */
+    class PredicateRegistry
+    {
+    public:
+        /**
+         *  Registers a predicate. Throws std::invalid_argument, if the name is already taken.
+         */
+        SharedPredicate const& add(std::string const& name, std::function <bool()> const& condition);
+
+        /**
+         *  Returns the predicate with the given name. Throws std::invalid_argument, if there is none.
+         */
+        SharedPredicate const& operator[](std::string const& name) const;
+
+        /**
+         *  Returns the amount of registered predicates.
+         */
+        std::size_t size() const;
+
+        /**
+         *  Returns the statistics summed over all registered predicates.
+         */
+        SharedPredicate::Statistics getStatistics() const;
+
+    private:
+        std::unordered_map <std::string, SharedPredicate> predicates_;
+    };
+}
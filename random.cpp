@@ -0,0 +1,25 @@
+#include "random.hpp"
+
+#include <atomic>
+#include <chrono>
+
+namespace MiniAutomata
+{
+    namespace
+    {
+        std::uint64_t clockSeed()
+        {
+            return static_cast <std::uint64_t> (std::chrono::system_clock::now().time_since_epoch().count());
+        }
+    }
+//#####################################################################################################################
+    std::uint64_t makeSeed()
+    {
+        static std::uint64_t const base = clockSeed();
+        static std::atomic <std::uint64_t> sequence{0};
+
+        CounterRandom generator{base, sequence.fetch_add(1, std::memory_order_relaxed)};
+        return generator();
+    }
+//#####################################################################################################################
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <random>
+
+namespace MiniAutomata
+{
+    /**
+     *  A small random engine (SplitMix64) working on external state, so that the state
+     *  can be kept in 8 bytes per automaton instance. Satisfies UniformRandomBitGenerator.
+     */
+    class SplitMix64
+    {
+    public:
+        using result_type = std::uint64_t;
+
+    public:
+        explicit SplitMix64(std::uint64_t& state)
+            : state_{state}
+        {
+        }
+
+        constexpr static result_type min()
+        {
+            return std::numeric_limits <result_type>::min();
+        }
+
+        constexpr static result_type max()
+        {
+            return std::numeric_limits <result_type>::max();
+        }
+
+        result_type operator()()
+        {
+            auto z = (state_ += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+
+    private:
+        std::uint64_t& state_;
+    };
+
+    /**
+     *  A counter based random engine in 16 bytes. The n-th output of a stream is a function of
+     *  the stream key and n alone, so jumping ahead is adding to the counter and independent
+     *  streams are obtained by drawing new keys. Every stream has period 2^64.
+     *  Satisfies UniformRandomBitGenerator.
+     */
+    class CounterRandom
+    {
+    public:
+        using result_type = std::uint64_t;
+
+    public:
+        explicit CounterRandom(std::uint64_t key = 0, std::uint64_t counter = 0)
+            : key_{key}
+            , counter_{counter}
+        {
+        }
+
+        constexpr static result_type min()
+        {
+            return std::numeric_limits <result_type>::min();
+        }
+
+        constexpr static result_type max()
+        {
+            return std::numeric_limits <result_type>::max();
+        }
+
+        result_type operator()()
+        {
+            // both rounds are bijections of the counter, so no value repeats within a period.
+            return mix(mix(counter_++ ^ key_) + key_);
+        }
+
+        /**
+         *  Restarts the stream with the given key.
+         */
+        void seed(std::uint64_t key)
+        {
+            key_ = key;
+            counter_ = 0;
+        }
+
+        /**
+         *  Skips the next n outputs in constant time.
+         */
+        void jump(std::uint64_t n)
+        {
+            counter_ += n;
+        }
+
+        /**
+         *  Same as jump, named like the standard engines.
+         */
+        void discard(std::uint64_t n)
+        {
+            jump(n);
+        }
+
+        /**
+         *  Returns a generator for a new independent stream, keyed by the next output of this one.
+         */
+        CounterRandom split()
+        {
+            return CounterRandom{(*this)()};
+        }
+
+        std::uint64_t key() const
+        {
+            return key_;
+        }
+
+        std::uint64_t counter() const
+        {
+            return counter_;
+        }
+
+    private:
+        static std::uint64_t mix(std::uint64_t z)
+        {
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+
+    private:
+        std::uint64_t key_;
+        std::uint64_t counter_;
+    };
+
+    /**
+     *  The random engine every Automaton carries. Defining MINIAUTOMATA_USE_MT19937
+     *  (cmake option AUTOMATA_MT19937) switches back to std::mt19937, which needs about 5 KB per automaton.
+     */
+#ifdef MINIAUTOMATA_USE_MT19937
+    using AutomatonRandom = std::mt19937;
+#else
+    using AutomatonRandom = CounterRandom;
+#endif
+
+    /**
+     *  Returns a different seed on every call without reading the clock, for default constructed engines.
+     *  Only the first call reads the clock.
+     */
+    std::uint64_t makeSeed();
+
+    /**
+     *  Returns a uniformly distributed integer in [0, bound), bound must not be 0.
+     *  Uses the low 32 bits of one or more draws (multiply and reject), so the result
+     *  only depends on the engine and is the same with every standard library.
+     */
+    template <typename GeneratorT>
+    std::uint32_t randomBelow(GeneratorT& generator, std::uint32_t bound)
+    {
+        auto product = static_cast <std::uint64_t> (static_cast <std::uint32_t> (generator())) * bound;
+        auto low = static_cast <std::uint32_t> (product);
+        if (low < bound)
+        {
+            auto threshold = static_cast <std::uint32_t> (-bound) % bound;
+            while (low < threshold)
+            {
+                product = static_cast <std::uint64_t> (static_cast <std::uint32_t> (generator())) * bound;
+                low = static_cast <std::uint32_t> (product);
+            }
+        }
+        return static_cast <std::uint32_t> (product >> 32);
+    }
+
+    /**
+     *  Returns a uniformly distributed double in [0, 1) from the low 32 bits of one draw.
+     */
+    template <typename GeneratorT>
+    double randomUnit(GeneratorT& generator)
+    {
+        return static_cast <std::uint32_t> (generator()) * (1.0 / 4294967296.0);
+    }
+}
@@ -0,0 +1,162 @@
+#include "replay.hpp"
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace MiniAutomata
+{
+	using namespace std::string_literals;
+//#####################################################################################################################
+    namespace
+    {
+        constexpr std::uint32_t recordingMagic = 0x4E555241u;
+        constexpr std::uint32_t recordingVersion = 2;
+
+        struct RecordingHeader
+        {
+            std::uint32_t magic;
+            std::uint32_t version;
+            std::uint64_t startBytes;
+            std::uint64_t stepCount;
+            std::uint64_t symbolCount;
+            std::uint64_t stateCount;
+            std::uint64_t outcomeCount;
+            std::uint64_t outcomeOffsetCount;
+            std::uint64_t choiceCount;
+        };
+
+        template <typename T>
+        void writeArray(std::ostream& stream, std::vector <T> const& data)
+        {
+            stream.write(reinterpret_cast <char const*> (data.data()), static_cast <std::streamsize> (data.size() * sizeof(T)));
+        }
+
+        template <typename T>
+        void readArray(std::istream& stream, std::vector <T>& data, std::uint64_t count)
+        {
+            // read in pieces, so that a corrupt count fails on the data instead of allocating it up front.
+            constexpr std::uint64_t piece = 1 << 16;
+            data.clear();
+            for (std::uint64_t done = 0; done != count;)
+            {
+                auto size = std::min(piece, count - done);
+                data.resize(static_cast <std::size_t> (done + size));
+                if (!stream.read(reinterpret_cast <char*> (data.data() + done), static_cast <std::streamsize> (size * sizeof(T))))
+                    throw std::invalid_argument("run recording is truncated");
+                done += size;
+            }
+        }
+    }
+//#####################################################################################################################
+    RunRecording::RunRecording()
+        : start_{}
+        , steps_{}
+        , symbols_{}
+        , states_{}
+        , outcomes_{}
+        , outcomeOffsets_{}
+        , choices_{}
+    {
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t RunRecording::stepCount() const
+    {
+        return steps_.size();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t RunRecording::outcomeCount() const
+    {
+        return outcomes_.size();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void RunRecording::clear()
+    {
+        start_.clear();
+        steps_.clear();
+        symbols_.clear();
+        states_.clear();
+        outcomes_.clear();
+        outcomeOffsets_.clear();
+        choices_.clear();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void RunRecording::addOutcome(std::size_t sequence, bool outcome)
+    {
+        outcomes_.push_back(static_cast <std::uint32_t> (sequence << 1) | (outcome ? 1u : 0u));
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    boost::optional <bool> RunRecording::findOutcome(std::size_t step, std::size_t sequence) const
+    {
+        // a step tests a handful of transitions, searching them is cheaper than indexing them.
+        auto first = std::begin(outcomes_) + static_cast <std::ptrdiff_t> (outcomeOffsets_[step]);
+        auto last = std::begin(outcomes_) + static_cast <std::ptrdiff_t> (outcomeOffsets_[step + 1]);
+        for (auto i = first; i != last; ++i)
+            if ((*i >> 1) == sequence)
+                return (*i & 1u) != 0;
+        return boost::none;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void RunRecording::save(std::ostream& stream) const
+    {
+        RecordingHeader header{
+            recordingMagic,
+            recordingVersion,
+            start_.size(),
+            steps_.size(),
+            symbols_.size(),
+            states_.size(),
+            outcomes_.size(),
+            outcomeOffsets_.size(),
+            choices_.size()
+        };
+        stream.write(reinterpret_cast <char const*> (&header), sizeof(header));
+        writeArray(stream, start_);
+        writeArray(stream, steps_);
+        writeArray(stream, symbols_);
+        writeArray(stream, states_);
+        writeArray(stream, outcomes_);
+        writeArray(stream, outcomeOffsets_);
+        writeArray(stream, choices_);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void RunRecording::load(std::istream& stream)
+    {
+        RecordingHeader header;
+        if (!stream.read(reinterpret_cast <char*> (&header), sizeof(header)))
+            throw std::invalid_argument("run recording is truncated");
+        if (header.magic != recordingMagic)
+            throw std::invalid_argument("not a run recording");
+        if (header.version != recordingVersion)
+        {
+            throw std::invalid_argument((
+                "run recording has version "s + std::to_string(header.version) +
+                ", expected " + std::to_string(recordingVersion)
+            ).c_str());
+        }
+
+        RunRecording loaded;
+        readArray(stream, loaded.start_, header.startBytes);
+        readArray(stream, loaded.steps_, header.stepCount);
+        readArray(stream, loaded.symbols_, header.symbolCount);
+        readArray(stream, loaded.states_, header.stateCount);
+        readArray(stream, loaded.outcomes_, header.outcomeCount);
+        readArray(stream, loaded.outcomeOffsets_, header.outcomeOffsetCount);
+        readArray(stream, loaded.choices_, header.choiceCount);
+
+        if (loaded.states_.size() != loaded.steps_.size() + 1 || loaded.outcomeOffsets_.size() != loaded.states_.size())
+            throw std::invalid_argument("run recording is corrupt");
+        if (loaded.outcomeOffsets_.front() != 0 || loaded.outcomeOffsets_.back() != loaded.outcomes_.size())
+            throw std::invalid_argument("run recording is corrupt");
+        if (!std::is_sorted(std::begin(loaded.outcomeOffsets_), std::end(loaded.outcomeOffsets_)))
+            throw std::invalid_argument("run recording is corrupt");
+        for (auto step : loaded.steps_)
+            if (static_cast <std::uint8_t> (step) > static_cast <std::uint8_t> (Step::consume))
+                throw std::invalid_argument("run recording is corrupt");
+
+        *this = std::move(loaded);
+    }
+//#####################################################################################################################
+}
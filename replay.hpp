@@ -0,0 +1,97 @@
+#pragma once
+
+#include "automata_fwd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+namespace MiniAutomata
+{
+    /**
+     *  Everything needed to repeat a run of an automaton without calling its conditions and selectors:
+     *  the dynamic state it started from (including the random engine), the kind of each step,
+     *  the outcome of each condition tested and each choice between several transitions.
+     *  Transitions are identified by their insertion sequence, so a run can be replayed on the same graph
+     *  whether it is frozen or not. The states passed through are kept to verify a replay against.
+     *  Record with Automaton::startRecording, replay with Automaton::replay.
+     */
+    class RunRecording
+    {
+    public:
+        RunRecording();
+
+        /**
+         *  Returns the amount of steps recorded.
+         */
+        std::size_t stepCount() const;
+
+        /**
+         *  Returns the amount of condition outcomes recorded.
+         */
+        std::size_t outcomeCount() const;
+
+        /**
+         *  Writes the recording in binary form.
+         */
+        void save(std::ostream& stream) const;
+
+        /**
+         *  Replaces the recording by one written by save().
+         *  Throws std::invalid_argument, if the data is corrupt.
+         */
+        void load(std::istream& stream);
+
+    private:
+        friend Automaton;
+        friend Transition;
+
+        enum class Step : std::uint8_t
+        {
+            advance = 0,
+            select = 1,
+            firstMatch = 2,
+            consume = 3
+        };
+
+        void clear();
+        void addOutcome(std::size_t sequence, bool outcome);
+
+        /**
+         *  Returns the outcome recorded for the transition in the step, none if it was not tested.
+         */
+        boost::optional <bool> findOutcome(std::size_t step, std::size_t sequence) const;
+
+    private:
+        // Automaton::checkpoint at the start.
+        std::vector <char> start_;
+
+        std::vector <Step> steps_;
+        std::vector <std::uint8_t> symbols_;
+
+        // The state before each step and after the last one.
+        std::vector <std::uint32_t> states_;
+
+        // (sequence << 1) | outcome, conditions of unconditional transitions are not recorded.
+        // The outcomes of a step start at its offset, the order they were tested in is not kept.
+        std::vector <std::uint32_t> outcomes_;
+        std::vector <std::uint64_t> outcomeOffsets_;
+
+        // Sequence of the transition taken, for each step that had more than one to choose from.
+        std::vector <std::uint32_t> choices_;
+    };
+
+    /**
+     *  The outcome of Automaton::replay.
+     */
+    struct ReplayResult
+    {
+        std::size_t steps;
+
+        // The first step that did not end in the recorded state, none if the replay matched.
+        boost::optional <std::size_t> divergence;
+    };
+}
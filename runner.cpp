@@ -0,0 +1,193 @@
+#include "runner.hpp"
+
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
+namespace MiniAutomata
+{
+    namespace
+    {
+        std::uint64_t packRange(std::uint64_t front, std::uint64_t back)
+        {
+            return (front << 32) | back;
+        }
+    }
+//#####################################################################################################################
+    ParallelRunner::ParallelRunner(std::size_t threadCount)
+        : queueStorage_{}
+        , queues_{nullptr}
+        , threadCount_{std::max <std::size_t> (threadCount, 1)}
+        , threads_{}
+        , batch_{nullptr}
+        , chunkSize_{1}
+        , mutex_{}
+        , start_{}
+        , done_{}
+        , generation_{0}
+        , busyWorkers_{0}
+        , stopping_{false}
+        , error_{}
+    {
+        std::size_t space = sizeof(WorkQueue) * threadCount_ + alignof(WorkQueue);
+        queueStorage_.reset(new char[space]);
+        void* storage = queueStorage_.get();
+        queues_ = static_cast <WorkQueue*> (std::align(alignof(WorkQueue), sizeof(WorkQueue) * threadCount_, storage, space));
+        for (std::size_t i = 0; i != threadCount_; ++i)
+        {
+            new (queues_ + i) WorkQueue;
+            queues_[i].range.store(0);
+            queues_[i].moved = 0;
+        }
+
+        // worker 0 is the thread calling tick.
+        threads_.reserve(threadCount_ - 1);
+        for (std::size_t i = 1; i < threadCount_; ++i)
+            threads_.emplace_back([this, i]() {workerLoop(i);});
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    ParallelRunner::~ParallelRunner()
+    {
+        {
+            std::lock_guard <std::mutex> lock{mutex_};
+            stopping_ = true;
+        }
+        start_.notify_all();
+        for (auto& thread : threads_)
+            thread.join();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t ParallelRunner::threadCount() const
+    {
+        return threadCount_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t ParallelRunner::tick(AutomatonBatch& batch, std::size_t chunkSize)
+    {
+        if (batch.size() == 0)
+            return 0;
+
+        chunkSize = std::max <std::size_t> (chunkSize, 1);
+        std::uint64_t chunks = (batch.size() + chunkSize - 1) / chunkSize;
+        if (chunks > 0xFFFFFFFFull)
+            throw std::length_error("too many chunks for one tick, increase the chunk size");
+
+        // deal the chunks out evenly.
+        for (std::size_t i = 0; i != threadCount_; ++i)
+        {
+            queues_[i].range.store(packRange(chunks * i / threadCount_, chunks * (i + 1) / threadCount_));
+            queues_[i].moved = 0;
+        }
+
+        {
+            std::lock_guard <std::mutex> lock{mutex_};
+            batch_ = &batch;
+            chunkSize_ = chunkSize;
+            busyWorkers_ = threadCount_ - 1;
+            error_ = nullptr;
+            ++generation_;
+        }
+        start_.notify_all();
+
+        work(0);
+
+        std::unique_lock <std::mutex> lock{mutex_};
+        done_.wait(lock, [this]() {return busyWorkers_ == 0;});
+        batch_ = nullptr;
+
+        if (error_)
+            std::rethrow_exception(error_);
+
+        std::size_t moved = 0;
+        for (std::size_t i = 0; i != threadCount_; ++i)
+            moved += queues_[i].moved;
+        return moved;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void ParallelRunner::workerLoop(std::size_t worker)
+    {
+        std::uint64_t seenGeneration = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock <std::mutex> lock{mutex_};
+                start_.wait(lock, [&]() {return stopping_ || generation_ != seenGeneration;});
+                if (stopping_)
+                    return;
+                seenGeneration = generation_;
+            }
+
+            work(worker);
+
+            std::lock_guard <std::mutex> lock{mutex_};
+            if (--busyWorkers_ == 0)
+                done_.notify_one();
+        }
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void ParallelRunner::work(std::size_t worker)
+    {
+        try
+        {
+            std::uint64_t chunk;
+            while (popFront(worker, chunk))
+                runChunk(worker, chunk);
+            while (stealBack(worker, chunk))
+                runChunk(worker, chunk);
+        }
+        catch (...)
+        {
+            std::lock_guard <std::mutex> lock{mutex_};
+            if (!error_)
+                error_ = std::current_exception();
+        }
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool ParallelRunner::popFront(std::size_t worker, std::uint64_t& chunk)
+    {
+        auto& range = queues_[worker].range;
+        auto current = range.load();
+        for (;;)
+        {
+            auto front = current >> 32;
+            auto back = current & 0xFFFFFFFFull;
+            if (front >= back)
+                return false;
+            if (range.compare_exchange_weak(current, packRange(front + 1, back)))
+            {
+                chunk = front;
+                return true;
+            }
+        }
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool ParallelRunner::stealBack(std::size_t worker, std::uint64_t& chunk)
+    {
+        for (std::size_t offset = 1; offset < threadCount_; ++offset)
+        {
+            auto& range = queues_[(worker + offset) % threadCount_].range;
+            auto current = range.load();
+            for (;;)
+            {
+                auto front = current >> 32;
+                auto back = current & 0xFFFFFFFFull;
+                if (front >= back)
+                    break;
+                if (range.compare_exchange_weak(current, packRange(front, back - 1)))
+                {
+                    chunk = back - 1;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void ParallelRunner::runChunk(std::size_t worker, std::uint64_t chunk)
+    {
+        auto first = static_cast <std::size_t> (chunk) * chunkSize_;
+        auto last = std::min(first + chunkSize_, batch_->size());
+        queues_[worker].moved += batch_->advance(first, last);
+    }
+//#####################################################################################################################
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "batch.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MiniAutomata
+{
+    /**
+     *  Advances the instances of a batch in parallel on a fixed pool of threads.
+     *  The batch is cut into chunks that are dealt out evenly to the workers. A worker that runs
+     *  out of chunks steals from the back of another worker's range, so instances with expensive
+     *  triggers do not stall the tick. Every instance carries its own random generator state,
+     *  so the outcome per instance does not depend on the thread count.
+     *  Triggers and actions are called concurrently and have to be thread safe.
+     */
+    class ParallelRunner
+    {
+    public:
+        /**
+         *  @param threadCount The amount of threads stepping, including the thread calling tick().
+         */
+        explicit ParallelRunner(std::size_t threadCount = std::thread::hardware_concurrency());
+        ~ParallelRunner();
+
+        ParallelRunner(ParallelRunner const&) = delete;
+        ParallelRunner& operator=(ParallelRunner const&) = delete;
+
+        /**
+         *  Returns the amount of threads stepping.
+         */
+        std::size_t threadCount() const;
+
+        /**
+         *  Advances every instance of the batch by one step.
+         *  Rethrows the first exception thrown by a trigger or action.
+         *
+         *  @param chunkSize The amount of instances a worker takes at once.
+         *  @return Returns the amount of instances that made a transition.
+         */
+        std::size_t tick(AutomatonBatch& batch, std::size_t chunkSize = 1024);
+
+    private:
+        // A range of chunks [front, back) packed into one word, so that the owner can pop
+        // from the front and thieves from the back with a single compare and swap.
+        // Queues of different workers are on different cache lines.
+        struct alignas(64) WorkQueue
+        {
+            std::atomic <std::uint64_t> range;
+            std::size_t moved;
+        };
+
+        void workerLoop(std::size_t worker);
+        void work(std::size_t worker);
+        bool popFront(std::size_t worker, std::uint64_t& chunk);
+        bool stealBack(std::size_t worker, std::uint64_t& chunk);
+        void runChunk(std::size_t worker, std::uint64_t chunk);
+
+    private:
+        // new only respects the alignment of WorkQueue from C++17 on, queues_ points into the storage.
+        std::unique_ptr <char[]> queueStorage_;
+        WorkQueue* queues_;
+        std::size_t threadCount_;
+        std::vector <std::thread> threads_;
+
+        // Current tick
+        AutomatonBatch* batch_;
+        std::size_t chunkSize_;
+
+        std::mutex mutex_;
+        std::condition_variable start_;
+        std::condition_variable done_;
+        std::uint64_t generation_;
+        std::size_t busyWorkers_;
+        bool stopping_;
+        std::exception_ptr error_;
+    };
+}
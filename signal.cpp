@@ -0,0 +1,22 @@
+#include "signal.hpp"
+
+namespace MiniAutomata
+{
+//#####################################################################################################################
+    Signal::Signal()
+        : version_{0}
+    {
+
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Signal::notify()
+    {
+        version_.fetch_add(1);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint64_t Signal::version() const
+    {
+        return version_.load();
+    }
+//#####################################################################################################################
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+namespace MiniAutomata
+{
+    /**
+     *  A signal is something trigger conditions can depend on.
+     *  Whoever changes the inputs of a condition notifies the signal, which bumps its version.
+     *  Triggers that declare their signals are only re-evaluated after one of them was notified.
+     */
+    class Signal
+    {
+    public:
+        Signal();
+
+        Signal(Signal const&) = delete;
+        Signal& operator=(Signal const&) = delete;
+
+        /**
+         *  Marks everything depending on this signal as dirty. Thread safe.
+         */
+        void notify();
+
+        /**
+         *  Returns the amount of notifications so far.
+         */
+        std::uint64_t version() const;
+
+    private:
+        std::atomic <std::uint64_t> version_;
+    };
+
+    /**
+     *  A value that notifies its signal whenever it is assigned.
+     */
+    template <typename T>
+    class Observable
+    {
+    public:
+        explicit Observable(T value = T{})
+            : value_(std::move(value))
+            , signal_{}
+        {
+        }
+
+        void set(T value)
+        {
+            value_ = std::move(value);
+            signal_.notify();
+        }
+
+        T const& get() const
+        {
+            return value_;
+        }
+
+        Signal const& signal() const
+        {
+            return signal_;
+        }
+
+    private:
+        T value_;
+        Signal signal_;
+    };
+}
@@ -1,137 +1,203 @@
 #include "state.hpp"
-
+
 namespace MiniAutomata
 {
-//#####################################################################################################################
-    ProtoState::ProtoState(const char* name)
-        : id_{boost::none}
-        , name_{name}
-    {
-
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    ProtoState::ProtoState(unsigned long long int id)
-        : id_{static_cast <int> (id)}
-        , name_{std::to_string(id)}
-    {
-
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    State ProtoState::operator()(int id)
-    {
-        return {id, std::move(name_)};
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    State ProtoState::operator()() &&
-    {
-        return {std::move(name_)};
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    ProtoState::StateBinding operator||(ProtoState&& lhs, std::string&& name)
-    {
-        if (lhs.id_)
-            return {{lhs.id_.get()}, {name}};
-        else
-            return {{lhs.name_}, {name}};
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    ProtoState::StateBinding operator||(ProtoState&& lhs, ProtoState&& rhs)
-    {
-        if (lhs.id_ && rhs.id_)
-            return {{lhs.id_.get()}, {rhs.id_.get()}};
-        else if (lhs.id_)
-            return {{lhs.id_.get()}, {rhs.name_}};
-        else
-            return {{lhs.name_}, {rhs.name_}};
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    ProtoState::StateBinding operator||(ProtoState&& lhs, int id)
-    {
-        if (lhs.id_)
-            return {{lhs.id_.get()}, {id}};
-        else
-            return {{lhs.name_}, {id}};
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    ProtoState::StateBinding operator||(ProtoState::StateBinding&& lhs, std::string&& name)
-    {
-        lhs.push_back({name});
-        return lhs;
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    ProtoState::StateBinding operator||(ProtoState::StateBinding&& lhs, ProtoState&& rhs)
-    {
-        if (rhs.id_)
-            lhs.emplace_back(rhs.id_.get());
-        else
-            lhs.emplace_back(rhs.name_);
-        return lhs;
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    ProtoState::StateBinding operator||(ProtoState::StateBinding&& lhs, ProtoState::StateBinding&& rhs)
-    {
-        lhs.insert(std::end(lhs), std::begin(rhs), std::end(rhs));
-        return lhs;
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    ProtoState::StateBinding operator||(ProtoState::StateBinding&& lhs, int id)
-    {
-        lhs.push_back({id});
-        return lhs;
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    ProtoState::StateBinding operator<(ProtoState&& proto, std::function <bool()> trig)
-    {
-        if (proto.id_)
-            return {{proto.id_.get(), trig}};
-        else
-            return {{proto.name_, trig}};
-    }
-//#####################################################################################################################
-    State::State(std::string&& name)
-        : id_{boost::none}
-        , name_{std::move(name)}
-        , action_{}
-    {
-
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    State::State(int id, std::string&& name)
-        : id_{id}
-        , name_{std::move(name)}
-        , action_{}
-    {
-
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    std::string State::getName() const
-    {
-        return name_;
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    boost::optional <int> State::getId() const
-    {
-        return id_;
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    void State::bindAction(std::function <void()> const& action)
-    {
-        action_ = action;
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    void State::operator()()
-    {
-        if (action_)
-            action_();
-    }
-//#####################################################################################################################
-    ProtoState operator "" _as(const char* name, std::size_t)
-    {
-        return ProtoState{name};
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    ProtoState operator "" _as(unsigned long long int id)
-    {
-        return ProtoState{id};
-    }
-}
+//#####################################################################################################################
+    ProtoState::ProtoState(const char* name)
+        : id_{boost::none}
+        , name_{name}
+    {
+
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    ProtoState::ProtoState(unsigned long long int id)
+        : id_{static_cast <int> (id)}
+        , name_{std::to_string(id)}
+    {
+
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    State ProtoState::operator()(int id)
+    {
+        return {id, std::move(name_)};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    State ProtoState::operator()() &&
+    {
+        return {std::move(name_)};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    ProtoState::StateBinding operator||(ProtoState&& lhs, std::string&& name)
+    {
+        if (lhs.id_)
+            return {{lhs.id_.get()}, {name}};
+        else
+            return {{lhs.name_}, {name}};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    ProtoState::StateBinding operator||(ProtoState&& lhs, ProtoState&& rhs)
+    {
+        if (lhs.id_ && rhs.id_)
+            return {{lhs.id_.get()}, {rhs.id_.get()}};
+        else if (lhs.id_)
+            return {{lhs.id_.get()}, {rhs.name_}};
+        else
+            return {{lhs.name_}, {rhs.name_}};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    ProtoState::StateBinding operator||(ProtoState&& lhs, int id)
+    {
+        if (lhs.id_)
+            return {{lhs.id_.get()}, {id}};
+        else
+            return {{lhs.name_}, {id}};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    ProtoState::StateBinding operator||(ProtoState::StateBinding&& lhs, std::string&& name)
+    {
+        lhs.push_back({name});
+        return lhs;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    ProtoState::StateBinding operator||(ProtoState::StateBinding&& lhs, ProtoState&& rhs)
+    {
+        if (rhs.id_)
+            lhs.emplace_back(rhs.id_.get());
+        else
+            lhs.emplace_back(rhs.name_);
+        return lhs;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    ProtoState::StateBinding operator||(ProtoState::StateBinding&& lhs, ProtoState::StateBinding&& rhs)
+    {
+        lhs.insert(std::end(lhs), std::begin(rhs), std::end(rhs));
+        return lhs;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    ProtoState::StateBinding operator||(ProtoState::StateBinding&& lhs, int id)
+    {
+        lhs.push_back({id});
+        return lhs;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    ProtoState::StateBinding operator<(ProtoState&& proto, std::function <bool()> trig)
+    {
+        return std::move(proto) < Trigger{trig};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    ProtoState::StateBinding operator<(ProtoState&& proto, Trigger const& trig)
+    {
+        if (proto.id_)
+            return {{proto.id_.get(), trig}};
+        else
+            return {{proto.name_, trig}};
+    }
+//#####################################################################################################################
+    State::State(std::string&& name)
+        : id_{boost::none}
+        , name_{std::move(name)}
+        , interned_{boost::none}
+        , action_{}
+        , accepting_{false}
+    {
+
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    State::State(int id, std::string&& name)
+        : id_{id}
+        , name_{std::move(name)}
+        , interned_{boost::none}
+        , action_{}
+        , accepting_{false}
+    {
+
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    State::State(State const& other)
+        : id_{other.id_}
+        , name_{other.getName().to_string()}
+        , interned_{boost::none}
+        , action_{other.action_}
+        , accepting_{other.accepting_}
+    {
+
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    State::State(State const& other, StringView interned)
+        : id_{other.id_}
+        , name_{}
+        , interned_{interned}
+        , action_{other.action_}
+        , accepting_{other.accepting_}
+    {
+
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    State& State::operator=(State const& other)
+    {
+        if (this != &other)
+            *this = State{other};
+        return *this;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void State::intern(NameTable& names, std::size_t index)
+    {
+        interned_ = names.intern(getName(), index);
+        std::string{}.swap(name_);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::vector <State> State::copyInterned(std::vector <State> const& states, NameTable& names)
+    {
+        std::vector <State> result;
+        result.reserve(states.size());
+        for (std::size_t i = 0; i != states.size(); ++i)
+            result.push_back(State{states[i], names.intern(states[i].getName(), i)});
+        return result;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    StringView State::getName() const
+    {
+        return interned_ ? interned_.get() : StringView{name_};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    boost::optional <int> State::getId() const
+    {
+        return id_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void State::bindAction(std::function <void()> const& action)
+    {
+        action_ = action;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool State::hasAction() const
+    {
+        return static_cast <bool> (action_);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void State::setAccepting(bool accepting)
+    {
+        accepting_ = accepting;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool State::isAccepting() const
+    {
+        return accepting_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void State::operator()() const
+    {
+        if (action_)
+            action_();
+    }
+//#####################################################################################################################
+    ProtoState operator "" _as(const char* name, std::size_t)
+    {
+        return ProtoState{name};
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    ProtoState operator "" _as(unsigned long long int id)
+    {
+        return ProtoState{id};
+    }
+}
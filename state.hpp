@@ -1,145 +1,199 @@
-#pragma once
-
-#include "automata_fwd.hpp"
-#include "trigger.hpp"
-
-#include <functional>
-#include <string>
-#include <vector>
-
-#include <boost/optional.hpp>
-
-namespace MiniAutomata
-{
-//#####################################################################################################################
-    // declaration
-    class State;
-//#####################################################################################################################
-    class ProtoState
-    {
-    public:
-        struct StateBindingElement
-        {
-            boost::optional <std::string> name;
-            boost::optional <int> id;
-            Trigger trig;
-
-            StateBindingElement(std::string const& name)
-                : name{name}
-                , id{boost::none}
-                , trig{}
-            {}
-
-            StateBindingElement(int id)
-                : name{boost::none}
-                , id{id}
-                , trig{}
-            {}
-
-            StateBindingElement(std::string const& name, std::function <bool()> trig)
-                : name{name}
-                , id{boost::none}
-                , trig{trig}
-            {}
-
-            StateBindingElement(int id, std::function <bool()> trig)
-                : name{boost::none}
-                , id{id}
-                , trig{trig}
-            {}
-        };
-
-        using StateBinding = std::vector <StateBindingElement>;
-
-    public:
-        friend Transition;
-
-    public:
-        ProtoState(const char* name /* null determinated */);
-        ProtoState(unsigned long long int id);
-
-        State operator()(int id);
-        State operator()() &&;
-
-        /**
-         *  Binds states together for transitions.
-         */
-        friend StateBinding operator||(ProtoState&& lhs, std::string&& name);
-
-        /**
-         *  Binds states together for transitions.
-         */
-        friend StateBinding operator||(ProtoState&& lhs, ProtoState&& rhs);
-
-        /**
-         *  Binds states together for transitions.
-         */
-        friend StateBinding operator||(ProtoState&& lhs, int id);
-
-        /**
-         *  Binds states together for transitions.
-         */
-        friend StateBinding operator||(StateBinding&& lhs, std::string&& name);
-
-        /**
-         *  Binds states together for transitions.
-         */
-        friend StateBinding operator||(StateBinding&& lhs, ProtoState&& rhs);
-
-        /**
-         *  Binds states together for transitions.
-         */
-        friend StateBinding operator||(StateBinding&& lhs, StateBinding&& rhs);
-
-        /**
-         *  Binds states together for transitions.
-         */
-        friend StateBinding operator||(StateBinding&& lhs, int id);
-
-        /**
-         *  Add triggers to protos
-         */
-        friend StateBinding operator<(ProtoState&& proto, std::function <bool()> trig);
-
-    private:
-        boost::optional <int> id_;
-        std::string name_;
-    };
-//#####################################################################################################################
-    class State
-    {
-    public:
-        State(std::string&& name);
-        State(int id, std::string&& name);
-
-        /**
-         *  Get state name.
-         */
-        std::string getName() const;
-
-        /**
-         *  Get state id (if assigned).
-         */
-        boost::optional <int> getId() const;
-
-        /**
-         *  Adds an action to the state. The action is called when this state is entered.
-         *
-         *  @param A functor called on state activation.
-         */
-        void bindAction(std::function <void()> const& action);
-
-        /**
-         *  Calls action_, if assigned.
-         */
-        void operator()();
-
-    private:
-        boost::optional <int> id_;
-        std::string name_;
-        std::function <void()> action_;
-    };
-//#####################################################################################################################
-    ProtoState operator "" _as(const char* name, std::size_t);
-    ProtoState operator "" _as(unsigned long long int id);
-}
+#pragma once
+
+#include "automata_fwd.hpp"
+#include "names.hpp"
+#include "trigger.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+namespace MiniAutomata
+{
+//#####################################################################################################################
+    // declaration
+    class State;
+//#####################################################################################################################
+    class ProtoState
+    {
+    public:
+        struct StateBindingElement
+        {
+            boost::optional <std::string> name;
+            boost::optional <int> id;
+            Trigger trig;
+
+            StateBindingElement(std::string const& name)
+                : name{name}
+                , id{boost::none}
+                , trig{}
+            {}
+
+            StateBindingElement(int id)
+                : name{boost::none}
+                , id{id}
+                , trig{}
+            {}
+
+            StateBindingElement(std::string const& name, Trigger const& trig)
+                : name{name}
+                , id{boost::none}
+                , trig{trig}
+            {}
+
+            StateBindingElement(int id, Trigger const& trig)
+                : name{boost::none}
+                , id{id}
+                , trig{trig}
+            {}
+        };
+
+        using StateBinding = std::vector <StateBindingElement>;
+
+    public:
+        friend Transition;
+
+    public:
+        ProtoState(const char* name /* null determinated */);
+        ProtoState(unsigned long long int id);
+
+        State operator()(int id);
+        State operator()() &&;
+
+        /**
+         *  Binds states together for transitions.
+         */
+        friend StateBinding operator||(ProtoState&& lhs, std::string&& name);
+
+        /**
+         *  Binds states together for transitions.
+         */
+        friend StateBinding operator||(ProtoState&& lhs, ProtoState&& rhs);
+
+        /**
+         *  Binds states together for transitions.
+         */
+        friend StateBinding operator||(ProtoState&& lhs, int id);
+
+        /**
+         *  Binds states together for transitions.
+         */
+        friend StateBinding operator||(StateBinding&& lhs, std::string&& name);
+
+        /**
+         *  Binds states together for transitions.
+         */
+        friend StateBinding operator||(StateBinding&& lhs, ProtoState&& rhs);
+
+        /**
+         *  Binds states together for transitions.
+         */
+        friend StateBinding operator||(StateBinding&& lhs, StateBinding&& rhs);
+
+        /**
+         *  Binds states together for transitions.
+         */
+        friend StateBinding operator||(StateBinding&& lhs, int id);
+
+        /**
+         *  Add triggers to protos
+         */
+        friend StateBinding operator<(ProtoState&& proto, std::function <bool()> trig);
+
+        /**
+         *  Add triggers to protos
+         */
+        friend StateBinding operator<(ProtoState&& proto, Trigger const& trig);
+
+    private:
+        boost::optional <int> id_;
+        std::string name_;
+    };
+//#####################################################################################################################
+    class State
+    {
+    public:
+        State(std::string&& name);
+        State(int id, std::string&& name);
+
+        /**
+         *  The name of a state in an automaton is kept by the automaton. A copy taken out of it keeps its own.
+         */
+        State(State const& other);
+        State(State&& other) = default;
+        State& operator=(State const& other);
+        State& operator=(State&& other) = default;
+
+        /**
+         *  Get state name.
+         */
+        StringView getName() const;
+
+        /**
+         *  Get state id (if assigned).
+         */
+        boost::optional <int> getId() const;
+
+        /**
+         *  Adds an action to the state. The action is called when this state is entered.
+         *
+         *  @param A functor called on state activation.
+         */
+        void bindAction(std::function <void()> const& action);
+
+        /**
+         *  Returns true, if an action is bound to this state.
+         */
+        bool hasAction() const;
+
+        /**
+         *  Marks the state as accepting, for automata used as recognizers of symbol streams.
+         */
+        void setAccepting(bool accepting = true);
+
+        /**
+         *  Returns true, if the state is accepting.
+         */
+        bool isAccepting() const;
+
+        /**
+         *  Calls action_, if assigned.
+         */
+        void operator()() const;
+
+    private:
+        friend Automaton;
+        friend AutomatonDefinition;
+        friend AutomatonBuilder;
+
+        /**
+         *  Copies the state, referring to the given name instead of copying it.
+         */
+        State(State const& other, StringView interned);
+
+        /**
+         *  Hands the name over to the table, the state refers to the table's copy afterwards.
+         */
+        void intern(NameTable& names, std::size_t index);
+
+        /**
+         *  Copies the states, referring to the names in the table instead of copying them.
+         */
+        static std::vector <State> copyInterned(std::vector <State> const& states, NameTable& names);
+
+    private:
+        boost::optional <int> id_;
+
+        // Owned until the state is added to an automaton or a builder, empty afterwards.
+        std::string name_;
+        boost::optional <StringView> interned_;
+
+        std::function <void()> action_;
+        bool accepting_;
+    };
+//#####################################################################################################################
+    ProtoState operator "" _as(const char* name, std::size_t);
+    ProtoState operator "" _as(unsigned long long int id);
+}
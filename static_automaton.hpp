@@ -0,0 +1,350 @@
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace MiniAutomata
+{
+    /**
+     *  A state known at compile time, for use with makeStaticAutomaton.
+     *  Written as 0_st, 1_st, ... or StaticState <0>{}.
+     */
+    template <std::size_t Index>
+    struct StaticState
+    {
+        constexpr static std::size_t index = Index;
+    };
+
+    /**
+     *  The condition of an unconditional static transition.
+     */
+    struct StaticAlways
+    {
+        constexpr bool operator()() const
+        {
+            return true;
+        }
+    };
+
+    /**
+     *  A static transition from state From to state To, guarded by a callable of type GuardT.
+     */
+    template <std::size_t From, std::size_t To, typename GuardT>
+    struct StaticEdge
+    {
+        constexpr static std::size_t from = From;
+        constexpr static std::size_t to = To;
+        GuardT guard;
+    };
+
+    /**
+     *  An action called when entering state Index.
+     */
+    template <std::size_t Index, typename ActionT>
+    struct StaticAction
+    {
+        constexpr static std::size_t index = Index;
+        ActionT action;
+    };
+
+    /**
+     *  Result of operator> chains: the collected transitions, the state the chain ends at
+     *  and the guard for the next transition.
+     */
+    template <std::size_t Tail, typename GuardT, typename... EdgesT>
+    struct StaticChain
+    {
+        GuardT guard;
+        std::tuple <EdgesT...> edges;
+    };
+
+    namespace StaticDetail
+    {
+        template <char... Digits>
+        constexpr bool isDecimal()
+        {
+            char const digits[] = {Digits...};
+            for (auto digit : digits)
+                if (digit != '\'' && (digit < '0' || digit > '9'))
+                    return false;
+            return true;
+        }
+
+        template <char... Digits>
+        constexpr std::size_t parseIndex()
+        {
+            static_assert(isDecimal <Digits...>(), "static states are written as decimal numbers, like 12_st");
+
+            char const digits[] = {Digits...};
+            std::size_t result = 0;
+            for (auto digit : digits)
+            {
+                // skip digit separators, as in 1'000_st.
+                if (digit != '\'')
+                    result = result * 10 + static_cast <std::size_t> (digit - '0');
+            }
+            return result;
+        }
+
+        template <typename T>
+        struct IsStaticState : std::false_type {};
+
+        template <std::size_t Index>
+        struct IsStaticState <StaticState <Index>> : std::true_type {};
+
+        template <typename T>
+        struct IsStaticChain : std::false_type {};
+
+        template <std::size_t Tail, typename GuardT, typename... EdgesT>
+        struct IsStaticChain <StaticChain <Tail, GuardT, EdgesT...>> : std::true_type {};
+
+        template <typename T>
+        using EnableIfGuard = typename std::enable_if <
+            !IsStaticState <typename std::decay <T>::type>::value && !IsStaticChain <typename std::decay <T>::type>::value
+        >::type;
+
+        // Items passed to makeStaticAutomaton contribute transitions, actions or both.
+        template <std::size_t Tail, typename GuardT, typename... EdgesT>
+        std::tuple <EdgesT...> edgesOf(StaticChain <Tail, GuardT, EdgesT...> const& chain)
+        {
+            return chain.edges;
+        }
+
+        template <std::size_t Index, typename ActionT>
+        std::tuple <> edgesOf(StaticAction <Index, ActionT> const&)
+        {
+            return {};
+        }
+
+        template <std::size_t Tail, typename GuardT, typename... EdgesT>
+        std::tuple <> actionsOf(StaticChain <Tail, GuardT, EdgesT...> const&)
+        {
+            return {};
+        }
+
+        template <std::size_t Index, typename ActionT>
+        std::tuple <StaticAction <Index, ActionT>> actionsOf(StaticAction <Index, ActionT> const& action)
+        {
+            return std::tuple <StaticAction <Index, ActionT>> {action};
+        }
+
+        template <std::size_t StateCount, typename TupleT, std::size_t... Is>
+        constexpr bool edgesInRange(std::index_sequence <Is...>)
+        {
+            bool const inRange[] = {true, (
+                std::tuple_element <Is, TupleT>::type::from < StateCount &&
+                std::tuple_element <Is, TupleT>::type::to < StateCount
+            )...};
+            for (auto i : inRange)
+                if (!i)
+                    return false;
+            return true;
+        }
+    }
+
+    template <char... Digits>
+    constexpr StaticState <StaticDetail::parseIndex <Digits...>()> operator "" _st()
+    {
+        return {};
+    }
+
+    /**
+     *  Transition without condition.
+     */
+    template <std::size_t From, std::size_t To>
+    StaticChain <To, StaticAlways, StaticEdge <From, To, StaticAlways>> operator>(StaticState <From>, StaticState <To>)
+    {
+        return {StaticAlways{}, std::make_tuple(StaticEdge <From, To, StaticAlways>{StaticAlways{}})};
+    }
+
+    /**
+     *  Sets the condition for the next transition.
+     */
+    template <std::size_t From, typename GuardT, typename = StaticDetail::EnableIfGuard <GuardT>>
+    StaticChain <From, typename std::decay <GuardT>::type> operator>(StaticState <From>, GuardT&& guard)
+    {
+        return {std::forward <GuardT> (guard), std::tuple <>{}};
+    }
+
+    /**
+     *  Continues a chain with a transition to another state.
+     */
+    template <std::size_t Tail, typename GuardT, typename... EdgesT, std::size_t To>
+    StaticChain <To, StaticAlways, EdgesT..., StaticEdge <Tail, To, GuardT>>
+    operator>(StaticChain <Tail, GuardT, EdgesT...>&& chain, StaticState <To>)
+    {
+        return {
+            StaticAlways{},
+            std::tuple_cat(std::move(chain.edges), std::make_tuple(StaticEdge <Tail, To, GuardT>{std::move(chain.guard)}))
+        };
+    }
+
+    /**
+     *  Sets the condition for the next transition of a chain.
+     */
+    template <std::size_t Tail, typename PriorT, typename... EdgesT, typename GuardT, typename = StaticDetail::EnableIfGuard <GuardT>>
+    StaticChain <Tail, typename std::decay <GuardT>::type, EdgesT...>
+    operator>(StaticChain <Tail, PriorT, EdgesT...>&& chain, GuardT&& guard)
+    {
+        return {std::forward <GuardT> (guard), std::move(chain.edges)};
+    }
+
+    /**
+     *  Binds an action that is called when the state is entered.
+     */
+    template <std::size_t Index, typename ActionT>
+    StaticAction <Index, typename std::decay <ActionT>::type> bindAction(StaticState <Index>, ActionT&& action)
+    {
+        return {std::forward <ActionT> (action)};
+    }
+
+    /**
+     *  An automaton whose states, transitions, guards and actions are all known at compile time.
+     *  Guards and actions are stored by value and called directly, so the compiler can inline them.
+     *  Stepping dispatches on the current state and tests the transitions of that state in declaration order,
+     *  the first one whose guard is true is taken.
+     */
+    template <std::size_t StateCount, typename EdgeTupleT, typename ActionTupleT>
+    class StaticAutomaton
+    {
+    public:
+        StaticAutomaton(EdgeTupleT edges, ActionTupleT actions)
+            : edges_(std::move(edges))
+            , actions_(std::move(actions))
+            , state_{0}
+        {
+        }
+
+        /**
+         *  Takes the first transition of the current state whose guard is true.
+         *
+         *  @return Returns true, if a transition has been made.
+         */
+        bool advance()
+        {
+            return dispatch(std::integral_constant <std::size_t, 0>{});
+        }
+
+        /**
+         *  Returns the index of the current state.
+         */
+        std::size_t getCurrentState() const
+        {
+            return state_;
+        }
+
+        /**
+         *  Returns true, if the automaton is in the given state.
+         */
+        template <std::size_t Index>
+        bool is(StaticState <Index>) const
+        {
+            return state_ == Index;
+        }
+
+        /**
+         *  Returns the amount of states.
+         */
+        constexpr static std::size_t stateCount()
+        {
+            return StateCount;
+        }
+
+    private:
+        bool dispatch(std::integral_constant <std::size_t, StateCount>)
+        {
+            return false;
+        }
+
+        // a chain of comparisons the compiler turns into a jump table.
+        template <std::size_t State>
+        bool dispatch(std::integral_constant <std::size_t, State>)
+        {
+            if (state_ == State)
+                return stepFrom <State> (std::integral_constant <std::size_t, 0>{});
+            return dispatch(std::integral_constant <std::size_t, State + 1>{});
+        }
+
+        template <std::size_t State>
+        bool stepFrom(std::integral_constant <std::size_t, std::tuple_size <EdgeTupleT>::value>)
+        {
+            return false;
+        }
+
+        template <std::size_t State, std::size_t Edge>
+        bool stepFrom(std::integral_constant <std::size_t, Edge>)
+        {
+            using EdgeT = typename std::tuple_element <Edge, EdgeTupleT>::type;
+            if (tryEdge <Edge> (std::integral_constant <bool, EdgeT::from == State>{}))
+                return true;
+            return stepFrom <State> (std::integral_constant <std::size_t, Edge + 1>{});
+        }
+
+        template <std::size_t Edge>
+        bool tryEdge(std::false_type)
+        {
+            return false;
+        }
+
+        template <std::size_t Edge>
+        bool tryEdge(std::true_type)
+        {
+            using EdgeT = typename std::tuple_element <Edge, EdgeTupleT>::type;
+            if (!std::get <Edge> (edges_).guard())
+                return false;
+            state_ = EdgeT::to;
+            enter <EdgeT::to> (std::integral_constant <std::size_t, 0>{});
+            return true;
+        }
+
+        template <std::size_t State>
+        void enter(std::integral_constant <std::size_t, std::tuple_size <ActionTupleT>::value>)
+        {
+        }
+
+        template <std::size_t State, std::size_t Action>
+        void enter(std::integral_constant <std::size_t, Action>)
+        {
+            using ActionT = typename std::tuple_element <Action, ActionTupleT>::type;
+            callAction <Action> (std::integral_constant <bool, ActionT::index == State>{});
+            enter <State> (std::integral_constant <std::size_t, Action + 1>{});
+        }
+
+        template <std::size_t Action>
+        void callAction(std::false_type)
+        {
+        }
+
+        template <std::size_t Action>
+        void callAction(std::true_type)
+        {
+            std::get <Action> (actions_).action();
+        }
+
+    private:
+        EdgeTupleT edges_;
+        ActionTupleT actions_;
+        std::size_t state_;
+    };
+
+    /**
+     *  Creates a static automaton with StateCount states, starting at state 0.
+     *  Takes any mix of transition chains (0_st > guard > 1_st > 2_st) and actions (bindAction(1_st, ...)).
+     */
+    template <std::size_t StateCount, typename... ItemsT>
+    auto makeStaticAutomaton(ItemsT&&... items)
+    {
+        auto edges = std::tuple_cat(StaticDetail::edgesOf(items)...);
+        auto actions = std::tuple_cat(StaticDetail::actionsOf(items)...);
+
+        using EdgeTupleT = decltype(edges);
+        static_assert(
+            StaticDetail::edgesInRange <StateCount, EdgeTupleT> (std::make_index_sequence <std::tuple_size <EdgeTupleT>::value>{}),
+            "transition refers to a state index not below StateCount"
+        );
+
+        return StaticAutomaton <StateCount, EdgeTupleT, decltype(actions)> {std::move(edges), std::move(actions)};
+    }
+}
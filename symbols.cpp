@@ -0,0 +1,131 @@
+#include "symbols.hpp"
+
+namespace MiniAutomata
+{
+//#####################################################################################################################
+    SymbolSet::SymbolSet()
+        : bits_{}
+        , epsilon_{false}
+    {
+
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    SymbolSet& SymbolSet::add(std::uint8_t symbol)
+    {
+        bits_.set(symbol);
+        return *this;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    SymbolSet& SymbolSet::add(std::uint8_t first, std::uint8_t last)
+    {
+        for (unsigned int i = first; i <= last; ++i)
+            bits_.set(i);
+        return *this;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    SymbolSet& SymbolSet::add(SymbolSet const& other)
+    {
+        bits_ |= other.bits_;
+        epsilon_ = epsilon_ || other.epsilon_;
+        return *this;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool SymbolSet::contains(std::uint8_t symbol) const
+    {
+        return bits_.test(symbol);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool SymbolSet::empty() const
+    {
+        return bits_.none();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool SymbolSet::isEpsilon() const
+    {
+        return epsilon_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::bitset <256> const& SymbolSet::bits() const
+    {
+        return bits_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    SymbolSet SymbolSet::epsilon()
+    {
+        SymbolSet result;
+        result.epsilon_ = true;
+        return result;
+    }
+//#####################################################################################################################
+    ByteClasses::ByteClasses()
+        : classes_{}
+        , count_{1}
+    {
+
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void ByteClasses::split(std::bitset <256> const& symbols)
+    {
+        // renumber (old class, inside) pairs in order of first appearance.
+        std::array <std::array <int, 2>, 256> renumbered;
+        for (auto& i : renumbered)
+            i = {{-1, -1}};
+
+        std::size_t next = 0;
+        for (unsigned int byte = 0; byte != 256; ++byte)
+        {
+            auto& slot = renumbered[classes_[byte]][symbols.test(byte) ? 1 : 0];
+            if (slot == -1)
+                slot = static_cast <int> (next++);
+            classes_[byte] = static_cast <std::uint8_t> (slot);
+        }
+        count_ = next;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint8_t ByteClasses::classOf(std::uint8_t byte) const
+    {
+        return classes_[byte];
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint8_t ByteClasses::representative(std::size_t byteClass) const
+    {
+        for (unsigned int byte = 0; byte != 256; ++byte)
+            if (classes_[byte] == byteClass)
+                return static_cast <std::uint8_t> (byte);
+        return 0;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t ByteClasses::count() const
+    {
+        return count_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::array <std::uint8_t, 256> const& ByteClasses::map() const
+    {
+        return classes_;
+    }
+//#####################################################################################################################
+    SymbolSet on(std::uint8_t symbol)
+    {
+        return SymbolSet{}.add(symbol);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    SymbolSet on(std::uint8_t first, std::uint8_t last)
+    {
+        return SymbolSet{}.add(first, last);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    SymbolSet onAnyOf(std::string const& symbols)
+    {
+        SymbolSet result;
+        for (auto c : symbols)
+            result.add(static_cast <std::uint8_t> (c));
+        return result;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    SymbolSet onAny()
+    {
+        return SymbolSet{}.add(0, 255);
+    }
+//#####################################################################################################################
+}
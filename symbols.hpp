@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <string>
+
+namespace MiniAutomata
+{
+    /**
+     *  The input symbols (bytes) a transition consumes. A transition labeled with symbols
+     *  is not taken by advance(), but only when one of its symbols is fed to the automaton.
+     */
+    class SymbolSet
+    {
+    public:
+        SymbolSet();
+
+        /**
+         *  Adds a single symbol.
+         */
+        SymbolSet& add(std::uint8_t symbol);
+
+        /**
+         *  Adds all symbols in [first, last].
+         */
+        SymbolSet& add(std::uint8_t first, std::uint8_t last);
+
+        /**
+         *  Adds all other symbols of the set. The result is an epsilon label, if either set is one.
+         */
+        SymbolSet& add(SymbolSet const& other);
+
+        /**
+         *  Returns true, if the symbol is part of the set.
+         */
+        bool contains(std::uint8_t symbol) const;
+
+        /**
+         *  Returns true, if the set contains no symbol.
+         */
+        bool empty() const;
+
+        /**
+         *  Returns true, if the transition consumes no input at all (epsilon transition).
+         */
+        bool isEpsilon() const;
+
+        /**
+         *  Returns the symbols as bits.
+         */
+        std::bitset <256> const& bits() const;
+
+        /**
+         *  Creates an epsilon label, for transitions taken without consuming input.
+         */
+        static SymbolSet epsilon();
+
+    private:
+        std::bitset <256> bits_;
+        bool epsilon_;
+    };
+
+    /**
+     *  A partition of all byte values into classes that no symbol set tells apart.
+     *  A jump table then only needs one column per class instead of one per byte.
+     */
+    class ByteClasses
+    {
+    public:
+        /**
+         *  Starts with all bytes in one class.
+         */
+        ByteClasses();
+
+        /**
+         *  Refines the classes, so that no class has bytes both inside and outside of the set.
+         */
+        void split(std::bitset <256> const& symbols);
+
+        /**
+         *  Returns the class of a byte.
+         */
+        std::uint8_t classOf(std::uint8_t byte) const;
+
+        /**
+         *  Returns some byte belonging to the class.
+         */
+        std::uint8_t representative(std::size_t byteClass) const;
+
+        /**
+         *  Returns the amount of classes.
+         */
+        std::size_t count() const;
+
+        /**
+         *  Returns the class of every byte.
+         */
+        std::array <std::uint8_t, 256> const& map() const;
+
+    private:
+        std::array <std::uint8_t, 256> classes_;
+        std::size_t count_;
+    };
+
+    /**
+     *  Label for a transition consuming the symbol.
+     */
+    SymbolSet on(std::uint8_t symbol);
+
+    /**
+     *  Label for a transition consuming any symbol in [first, last].
+     */
+    SymbolSet on(std::uint8_t first, std::uint8_t last);
+
+    /**
+     *  Label for a transition consuming any of the characters in the string.
+     */
+    SymbolSet onAnyOf(std::string const& symbols);
+
+    /**
+     *  Label for a transition consuming any symbol.
+     */
+    SymbolSet onAny();
+}
@@ -0,0 +1,96 @@
+#include "../automata.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+/*
+ *  advance() and advance(selector) must not allocate once the automaton has stepped through its states:
+ *  counts every operator new while stepping, frozen and unfrozen, with more active transitions
+ *  than TransitionSet stores inline.
+ */
+
+namespace
+{
+    bool counting = false;
+    std::size_t allocations = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    if (counting)
+        ++allocations;
+    if (void* memory = std::malloc(size == 0 ? 1 : size))
+        return memory;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace
+{
+    using namespace MiniAutomata;
+
+    constexpr int stateCount = 16;
+    constexpr int fanout = 2 * TransitionSet::inlineCapacity + 3;
+    constexpr int steps = 100000;
+
+    Automaton makeGraph()
+    {
+        auto automat = makeAutomaton();
+        for (int i = 0; i != stateCount; ++i)
+            automat << State{i, "s" + std::to_string(i)};
+        for (int i = 0; i != stateCount; ++i)
+            for (int j = 0; j != fanout; ++j)
+                automat > i > [](){return true;} > (i + j) % stateCount;
+        return automat;
+    }
+
+    template <typename StepT>
+    bool check(char const* name, Automaton& automat, StepT&& step)
+    {
+        // warm up: every state is visited, so the spill capacity of the active set is reached.
+        for (int i = 0; i != steps; ++i)
+            step(automat);
+
+        allocations = 0;
+        counting = true;
+        for (int i = 0; i != steps; ++i)
+            step(automat);
+        counting = false;
+
+        std::cout << name << ": " << allocations << " allocations\n";
+        return allocations == 0;
+    }
+}
+
+int main()
+{
+    auto random = [](Automaton& automat) {
+        automat.advance();
+    };
+    auto selector = [](Automaton& automat) {
+        automat.advance([](TransitionSet const& active) {
+            return std::begin(active) + (active.size() - 1);
+        });
+    };
+
+    bool passed = true;
+    auto automat = makeGraph();
+    passed &= check("advance", automat, random);
+    passed &= check("advance(selector)", automat, selector);
+
+    automat.freeze();
+    passed &= check("advance frozen", automat, random);
+    passed &= check("advance(selector) frozen", automat, selector);
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+#include "../automata.hpp"
+
+#include <iostream>
+#include <vector>
+
+/*
+ *  A definition lists the edges of a state in insertion order, the same order Automaton uses,
+ *  so that runs over definitions do not depend on the standard library.
+ */
+
+namespace
+{
+    using namespace MiniAutomata;
+
+    constexpr int stateCount = 40;
+
+    std::vector <std::size_t> definitionTargets(AutomatonDefinition const& definition, std::size_t state)
+    {
+        std::vector <std::size_t> targets;
+        for (auto i = definition.edgesBegin(state); i != definition.edgesEnd(state); ++i)
+            targets.push_back(i->to);
+        return targets;
+    }
+
+    std::vector <std::size_t> activeTargets(Automaton& automat, std::size_t state)
+    {
+        std::vector <std::size_t> targets;
+        automat.setCurrentState(state);
+        for (auto const* transition : automat.getActiveTransitions())
+            targets.push_back(transition->getTarget());
+        return targets;
+    }
+}
+
+int main()
+{
+    auto automat = makeAutomaton();
+    for (int i = 0; i != stateCount; ++i)
+        automat << State{i, "s" + std::to_string(i)};
+
+    // state 0 gets its targets in a scrambled order, every other state a few descending ones.
+    std::vector <std::size_t> inserted;
+    for (int i = 1; i != stateCount; ++i)
+    {
+        auto target = (i * 17) % (stateCount - 1) + 1;
+        automat > 0 > target;
+        inserted.push_back(static_cast <std::size_t> (target));
+    }
+    for (int i = 1; i != stateCount; ++i)
+        for (int j = 3; j != 0; --j)
+            automat > i > (i + j) % stateCount;
+
+    bool passed = true;
+    auto check = [&passed](bool condition, char const* what) {
+        std::cout << (condition ? "ok   " : "FAIL ") << what << "\n";
+        passed &= condition;
+    };
+
+    AutomatonDefinition unfrozen{automat};
+    check(definitionTargets(unfrozen, 0) == inserted, "unfrozen definition lists edges in insertion order");
+
+    bool sameAsAutomaton = true;
+    for (std::size_t state = 0; state != stateCount; ++state)
+        sameAsAutomaton &= definitionTargets(unfrozen, state) == activeTargets(automat, state);
+    check(sameAsAutomaton, "unfrozen definition has the order of the active transitions");
+
+    automat.freeze();
+    AutomatonDefinition frozen{automat};
+    bool sameAsFrozen = true;
+    for (std::size_t state = 0; state != stateCount; ++state)
+        sameAsFrozen &= definitionTargets(frozen, state) == definitionTargets(unfrozen, state);
+    check(sameAsFrozen, "frozen definition has the same order without priorities");
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+#include "../automata.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+
+/*
+ *  A run recorded on a frozen automaton replays on an unfrozen copy of the same graph and the other way around,
+ *  although the two test conditions and pick random transitions in different orders.
+ */
+
+namespace
+{
+    using namespace MiniAutomata;
+
+    constexpr int stateCount = 4;
+
+    bool passed = true;
+
+    void check(bool condition, char const* what)
+    {
+        std::cout << (condition ? "ok   " : "FAIL ") << what << "\n";
+        passed &= condition;
+    }
+
+    // a deterministic coin, so that both runs see the same conditions.
+    struct Coin
+    {
+        std::uint32_t state = 12345;
+        std::size_t calls = 0;
+
+        bool operator()()
+        {
+            ++calls;
+            state = state * 1103515245u + 12345u;
+            return (state >> 16) & 1u;
+        }
+    };
+
+    Automaton makeGraph(Coin& coin, bool frozen)
+    {
+        auto automat = makeAutomaton();
+        for (int i = 0; i != stateCount; ++i)
+            automat << State{i, "s" + std::to_string(i)};
+
+        // later transitions get higher priorities, so a frozen automaton tests them first.
+        for (int from = 0; from != stateCount; ++from)
+        {
+            automat > from > Weight{1.} > (from + 1) % stateCount;
+            for (int to = 0; to != stateCount; ++to)
+            {
+                if (to == (from + 1) % stateCount)
+                    continue;
+                automat > from > Priority{to} > Weight{1. + to} > [&coin]{ return coin(); } > to;
+            }
+            automat > from > on('x') > Weight{1.} > (from + 2) % stateCount;
+            automat > from > on('x') > Weight{3.} > (from + 3) % stateCount;
+        }
+
+        if (frozen)
+            automat.freeze();
+        return automat;
+    }
+
+    void run(Automaton& automat)
+    {
+        for (int i = 0; i != 200; ++i)
+        {
+            switch (i % 4)
+            {
+                case 0:
+                    automat.advance();
+                    break;
+                case 1:
+                    automat.advance([](TransitionSet const& active) {
+                        return std::end(active) - 1;
+                    });
+                    break;
+                case 2:
+                    automat.advanceFirstMatch();
+                    break;
+                case 3:
+                    automat.consume('x');
+                    break;
+            }
+        }
+    }
+
+    void checkReplay(char const* kind, bool recordFrozen)
+    {
+        std::cout << kind << ":\n";
+
+        Coin coin;
+        auto recorded = makeGraph(coin, recordFrozen);
+        RunRecording recording;
+        recorded.startRecording(recording);
+        run(recorded);
+        recorded.stopRecording();
+
+        std::stringstream stream;
+        recording.save(stream);
+        RunRecording loaded;
+        loaded.load(stream);
+
+        Coin replayCoin;
+        auto replayed = makeGraph(replayCoin, !recordFrozen);
+        auto result = replayed.replay(loaded);
+
+        check(coin.calls != 0 && recording.outcomeCount() != 0, "the run tested conditions");
+        check(!result.divergence, "the replay follows the recorded states");
+        check(result.steps == recording.stepCount(), "the replay repeats every step");
+        check(replayCoin.calls == 0, "the replay does not test conditions");
+        check(replayed.getCurrentStateIndex() == recorded.getCurrentStateIndex(), "the replay ends where the run did");
+    }
+}
+
+int main()
+{
+    checkReplay("recorded frozen, replayed unfrozen", true);
+    checkReplay("recorded unfrozen, replayed frozen", false);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+#include "../automata.hpp"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+/*
+ *  The states of an automaton refer to the names in its lookup table. The names have to survive growth,
+ *  copies and moves, and states taken out of an automaton have to keep their own.
+ */
+
+int main()
+{
+    using namespace MiniAutomata;
+
+    constexpr int stateCount = 1000;
+
+    bool passed = true;
+    auto check = [&passed](bool condition, char const* what) {
+        std::cout << (condition ? "ok   " : "FAIL ") << what << "\n";
+        passed &= condition;
+    };
+
+    auto nameOf = [](int i) { return "state number " + std::to_string(i); };
+
+    auto automat = std::make_unique <Automaton> (makeAutomaton());
+    for (int i = 0; i != stateCount; ++i)
+        *automat << State{i, nameOf(i)};
+    for (int i = 0; i != stateCount; ++i)
+        *automat > i > (i + 1) % stateCount;
+
+    bool allFound = true;
+    for (int i = 0; i < stateCount; i += 37)
+        allFound &= automat->findState(nameOf(i)) == static_cast <std::size_t> (i);
+    check(allFound, "names stay valid while the states grow");
+
+    automat->setCurrentState(stateCount - 1);
+    check((*std::begin(automat->getActiveTransitions()))->getTargetName() == nameOf(0), "transitions name their targets");
+
+    auto definition = std::make_unique <AutomatonDefinition> (*automat);
+    auto copy = std::make_unique <Automaton> (*automat);
+    auto moved = std::move(*automat);
+    automat.reset();
+
+    check(copy->getCurrentStateName() == StringView{nameOf(stateCount - 1)}, "a copy keeps its names");
+    copy.reset();
+    moved.setCurrentState(12);
+    check(moved.getCurrentStateName() == StringView{nameOf(12)}, "a moved automaton keeps its names");
+
+    State taken = definition->getState(7);
+    definition.reset();
+    check(taken.getName() == nameOf(7), "a state copied out of a definition keeps its name");
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+#include "../automata.hpp"
+
+#include <iostream>
+#include <type_traits>
+
+/*
+ *  Compiles and steps a static automaton, and checks how state literals are parsed.
+ */
+
+using namespace MiniAutomata;
+
+static_assert(std::is_same <decltype(12_st), StaticState <12>>::value, "decimal literal");
+static_assert(std::is_same <decltype(1'000_st), StaticState <1000>>::value, "digit separators are skipped");
+static_assert(std::is_same <decltype(007_st), StaticState <7>>::value, "leading zeros are decimal");
+
+int main()
+{
+    bool connected = false;
+    int entered = 0;
+
+    auto machine = makeStaticAutomaton <3> (
+        0_st > [&]{ return connected; } > 1_st > 2_st,
+        2_st > 0_st,
+        bindAction(2_st, [&]{ ++entered; })
+    );
+
+    bool passed = true;
+    passed &= !machine.advance() && machine.is(0_st);
+
+    connected = true;
+    passed &= machine.advance() && machine.is(1_st);
+    passed &= machine.advance() && machine.is(2_st) && entered == 1;
+    passed &= machine.advance() && machine.getCurrentState() == 0;
+    passed &= decltype(machine)::stateCount() == 3;
+
+    std::cout << (passed ? "ok" : "FAIL") << "\n";
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+#include "../automata.hpp"
+
+#include <iostream>
+
+/*
+ *  Labeled transitions to the same state are merged only if they differ in nothing but their symbols,
+ *  both when written with the dsl and when built by AutomatonBuilder.
+ */
+
+namespace
+{
+    using namespace MiniAutomata;
+
+    bool passed = true;
+
+    void check(bool condition, char const* what)
+    {
+        std::cout << (condition ? "ok   " : "FAIL ") << what << "\n";
+        passed &= condition;
+    }
+
+    void checkAutomaton(char const* kind, Automaton& automat)
+    {
+        std::cout << kind << ":\n";
+        check(automat.transitionCount() == 5, "guarded, prioritized and epsilon edges are kept apart");
+
+        automat.setCurrentState(automat.findState("S").get());
+        check(automat.consume('b'), "unguarded 'b' is not blocked by the guard of 'a'");
+        check(automat.getCurrentStateIndex() == automat.findState("T").get(), "'b' leads to T");
+
+        automat.setCurrentState(automat.findState("S").get());
+        check(!automat.consume('a'), "guarded 'a' stays guarded");
+
+        automat.setCurrentState(automat.findState("S").get());
+        check(automat.consume('d'), "merged 'd' is consumed");
+        automat.setCurrentState(automat.findState("S").get());
+        check(automat.consume('c'), "merged 'c' is consumed");
+    }
+}
+
+int main()
+{
+    auto never = [](){return false;};
+
+    auto automat = makeAutomaton() << "S"_as(0) << "T"_as(1) << "U"_as(2);
+    automat > "S" > on('a') > never > "T";
+    automat > "S" > on('b') > "T";
+    automat > "S" > on('c') > "U";
+    automat > "S" > on('d') > "U";
+    automat > "S" > on('e') > Priority{1} > "U";
+    automat > "S" > SymbolSet::epsilon() > "U";
+    checkAutomaton("dsl", automat);
+
+    AutomatonBuilder builder;
+    builder.addState(State{0, "S"});
+    builder.addState(State{1, "T"});
+    builder.addState(State{2, "U"});
+    builder.addEdge(0, 1, Trigger{never}, on('a'));
+    builder.addEdge(0, 1, boost::none, on('b'));
+    builder.addEdge(0, 2, boost::none, on('c'));
+    builder.addEdge(0, 2, boost::none, on('d'));
+    builder.addEdge(0, 2, boost::none, on('e'), 1);
+    builder.addEdge(0, 2, boost::none, SymbolSet::epsilon());
+    auto built = builder.build();
+    checkAutomaton("builder", built);
+
+    return passed ? 0 : 1;
+}
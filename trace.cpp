@@ -0,0 +1,213 @@
+#include "trace.hpp"
+
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace MiniAutomata
+{
+	using namespace std::string_literals;
+//#####################################################################################################################
+    namespace
+    {
+        constexpr std::uint32_t logMagic = 0x43525441u;
+        constexpr std::uint32_t logVersion = 1;
+
+        // Followed by the varint encoded records of the block.
+        struct BlockHeader
+        {
+            std::uint32_t magic;
+            std::uint32_t version;
+            std::uint64_t count;
+            std::uint64_t bytes;
+        };
+
+        void putVarint(std::vector <char>& out, std::uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast <char> ((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast <char> (value));
+        }
+
+        std::uint64_t getVarint(char const*& in, char const* end)
+        {
+            std::uint64_t value = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7)
+            {
+                if (in == end)
+                    throw std::invalid_argument("trace log is truncated");
+                auto byte = static_cast <unsigned char> (*in++);
+                value |= static_cast <std::uint64_t> (byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                    return value;
+            }
+            throw std::invalid_argument("trace log is corrupt");
+        }
+
+        // Records of different threads are not strictly ordered, so differences can be negative.
+        std::uint64_t zigzag(std::uint64_t current, std::uint64_t previous)
+        {
+            auto difference = current - previous;
+            return (difference << 1) ^ (0 - (difference >> 63));
+        }
+
+        std::uint64_t unzigzag(std::uint64_t value, std::uint64_t previous)
+        {
+            return previous + ((value >> 1) ^ (0 - (value & 1)));
+        }
+    }
+//#####################################################################################################################
+    TraceRecorder::TraceRecorder(std::size_t capacity)
+        : slots_{}
+        , mask_{0}
+        , padding0_{}
+        , head_{0}
+        , dropped_{0}
+        , padding1_{}
+        , tail_{0}
+        , consumer_{}
+    {
+        std::size_t size = 1;
+        while (size < capacity)
+            size *= 2;
+        mask_ = size - 1;
+
+        // a slot is free for the record with the same sequence number and full for sequence + 1.
+        slots_.reset(new Slot[size]);
+        for (std::size_t i = 0; i != size; ++i)
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool TraceRecorder::record(TraceRecord const& record)
+    {
+        auto position = head_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto& slot = slots_[position & mask_];
+            auto sequence = slot.sequence.load(std::memory_order_acquire);
+            auto difference = static_cast <std::int64_t> (sequence - position);
+            if (difference == 0)
+            {
+                if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.record = record;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+                position = head_.load(std::memory_order_relaxed);
+        }
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    template <typename FunctionT>
+    std::size_t TraceRecorder::consume(FunctionT&& func)
+    {
+        std::lock_guard <std::mutex> lock{consumer_};
+        std::size_t count = 0;
+        for (;;)
+        {
+            auto& slot = slots_[tail_ & mask_];
+            if (slot.sequence.load(std::memory_order_acquire) != tail_ + 1)
+                return count;
+
+            func(slot.record);
+            slot.sequence.store(tail_ + mask_ + 1, std::memory_order_release);
+            ++tail_;
+            ++count;
+        }
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t TraceRecorder::drain(std::vector <TraceRecord>& records)
+    {
+        return consume([&records](TraceRecord const& record) {
+            records.push_back(record);
+        });
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t TraceRecorder::drain(std::ostream& log)
+    {
+        std::vector <char> payload;
+        TraceRecord previous{0, 0, 0, 0, 0};
+        auto count = consume([&payload, &previous](TraceRecord const& record) {
+            putVarint(payload, zigzag(record.timestamp, previous.timestamp));
+            putVarint(payload, zigzag(record.instance, previous.instance));
+            putVarint(payload, record.from);
+            putVarint(payload, record.to);
+            putVarint(payload, record.edge);
+            previous = record;
+        });
+
+        if (count == 0)
+            return 0;
+
+        BlockHeader header{logMagic, logVersion, count, payload.size()};
+        log.write(reinterpret_cast <char const*> (&header), sizeof(header));
+        log.write(payload.data(), static_cast <std::streamsize> (payload.size()));
+        return count;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint64_t TraceRecorder::dropped() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t TraceRecorder::capacity() const
+    {
+        return mask_ + 1;
+    }
+//#####################################################################################################################
+    std::size_t readTraceLog(std::istream& log, std::vector <TraceRecord>& records)
+    {
+        std::size_t total = 0;
+        BlockHeader header;
+        while (log.read(reinterpret_cast <char*> (&header), sizeof(header)))
+        {
+            if (header.magic != logMagic)
+                throw std::invalid_argument("not a trace log");
+            if (header.version != logVersion)
+                throw std::invalid_argument(("trace log has version "s + std::to_string(header.version) + ", expected " + std::to_string(logVersion)).c_str());
+
+            // every record takes at least 5 bytes, which bounds the count before reserving.
+            if (header.count > header.bytes / 5)
+                throw std::invalid_argument("trace log is corrupt");
+
+            std::vector <char> payload(static_cast <std::size_t> (header.bytes));
+            if (!log.read(payload.data(), static_cast <std::streamsize> (payload.size())))
+                throw std::invalid_argument("trace log is truncated");
+
+            char const* in = payload.data();
+            char const* end = in + payload.size();
+            TraceRecord previous{0, 0, 0, 0, 0};
+            records.reserve(records.size() + static_cast <std::size_t> (header.count));
+            for (std::uint64_t i = 0; i != header.count; ++i)
+            {
+                TraceRecord record;
+                record.timestamp = unzigzag(getVarint(in, end), previous.timestamp);
+                record.instance = unzigzag(getVarint(in, end), previous.instance);
+                record.from = static_cast <std::uint32_t> (getVarint(in, end));
+                record.to = static_cast <std::uint32_t> (getVarint(in, end));
+                record.edge = static_cast <std::uint32_t> (getVarint(in, end));
+                records.push_back(record);
+                previous = record;
+            }
+            if (in != end)
+                throw std::invalid_argument("trace log is corrupt");
+            total += static_cast <std::size_t> (header.count);
+        }
+
+        if (log.gcount() != 0)
+            throw std::invalid_argument("trace log is truncated");
+        return total;
+    }
+//#####################################################################################################################
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "automata_fwd.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace MiniAutomata
+{
+    /**
+     *  One performed transition.
+     */
+    struct TraceRecord
+    {
+        // Nanoseconds of Instrumentation::now().
+        std::uint64_t timestamp;
+
+        // Set by the recording automaton, see Automaton::setTraceRecorder.
+        std::uint64_t instance;
+
+        std::uint32_t from;
+        std::uint32_t to;
+
+        // Transition::getSequence() of the transition taken.
+        std::uint32_t edge;
+    };
+
+    /**
+     *  Collects transitions of any number of automata on any number of threads in a preallocated ring buffer.
+     *  Recording never allocates or locks, a full buffer drops the record and counts it instead.
+     *  A consumer drains the buffer regularly, into memory or into a compact binary log.
+     */
+    class TraceRecorder
+    {
+    public:
+        /**
+         *  @param capacity The amount of records the buffer holds, rounded up to a power of two.
+         */
+        explicit TraceRecorder(std::size_t capacity = 1 << 16);
+
+        TraceRecorder(TraceRecorder const&) = delete;
+        TraceRecorder& operator=(TraceRecorder const&) = delete;
+
+        /**
+         *  Appends a record. Safe to call from any thread.
+         *
+         *  @return Returns false, if the buffer was full and the record was dropped.
+         */
+        bool record(TraceRecord const& record);
+
+        /**
+         *  Moves all records recorded so far to the end of the vector.
+         *
+         *  @return Returns the amount of records moved.
+         */
+        std::size_t drain(std::vector <TraceRecord>& records);
+
+        /**
+         *  Writes all records recorded so far to the log as one block. Blocks can be appended to the same log,
+         *  readTraceLog reads them back. Records take about 8 bytes each, as differences to the previous record.
+         *
+         *  @return Returns the amount of records written.
+         */
+        std::size_t drain(std::ostream& log);
+
+        /**
+         *  Returns how many records were dropped because the buffer was full.
+         */
+        std::uint64_t dropped() const;
+
+        /**
+         *  Returns the amount of records the buffer holds.
+         */
+        std::size_t capacity() const;
+
+    private:
+        struct Slot
+        {
+            std::atomic <std::uint64_t> sequence;
+            TraceRecord record;
+        };
+
+        template <typename FunctionT>
+        std::size_t consume(FunctionT&& func);
+
+    private:
+        std::unique_ptr <Slot[]> slots_;
+        std::size_t mask_;
+
+        // producers and the consumer work on different cache lines.
+        char padding0_[64];
+        std::atomic <std::uint64_t> head_;
+        std::atomic <std::uint64_t> dropped_;
+        char padding1_[64];
+        std::uint64_t tail_;
+        std::mutex consumer_;
+    };
+
+    /**
+     *  Reads all blocks of a log written by TraceRecorder::drain and appends their records.
+     *  Throws std::invalid_argument, if the log is corrupt.
+     *
+     *  @return Returns the amount of records read.
+     */
+    std::size_t readTraceLog(std::istream& log, std::vector <TraceRecord>& records);
+}
@@ -1,89 +1,127 @@
-#include "transition.hpp"
+#include "transition.hpp"
 #include "automata.hpp"
-
+
 namespace MiniAutomata
 {
-//#####################################################################################################################
-    Transition::Transition(Automaton* parent, std::size_t to, boost::optional <Trigger> const& trig)
-        : parent_{parent}
-        , to_{to}
-        , trigger_{trig ? trig.get() : Trigger{}}
-    {
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    bool Transition::test() const
-    {
-        return trigger_.test();
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    void Transition::perform() const
-    {
-        parent_->setState(to_);
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    std::string Transition::getTargetName() const
-    {
-        return parent_->states_[to_].getName();
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    std::size_t Transition::getTarget() const
-    {
-        return to_;
-    }
-//#####################################################################################################################
-    TransitionSet::TransitionSet()
-        : transitions_{}
-    {
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    void TransitionSet::insert(Transition* trans)
-    {
-        transitions_.insert(trans);
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    std::unordered_set <Transition*>::iterator TransitionSet::begin()
-    {
-        return std::begin(transitions_);
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    std::unordered_set <Transition*>::iterator TransitionSet::end()
-    {
-        return std::end(transitions_);
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    std::unordered_set <Transition*>::const_iterator TransitionSet::begin() const
-    {
-        return cbegin();
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    std::unordered_set <Transition*>::const_iterator TransitionSet::end() const
-    {
-        return cend();
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    std::unordered_set <Transition*>::const_iterator TransitionSet::cbegin() const
-    {
-        return transitions_.cbegin();
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    std::unordered_set <Transition*>::const_iterator TransitionSet::cend() const
-    {
-        return transitions_.cend();
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    Transition* TransitionSet::first()
-    {
-        return *std::begin(transitions_);
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    bool TransitionSet::empty() const
-    {
-        return transitions_.empty();
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    std::size_t TransitionSet::size() const
-    {
-        return transitions_.size();
+//#####################################################################################################################
+    Transition::Transition(
+        Automaton* parent,
+        std::size_t to,
+        boost::optional <Trigger> const& trig,
+        boost::optional <SymbolSet> const& symbols
+    )
+        : parent_{parent}
+        , to_{to}
+        , trigger_{trig ? trig.get() : Trigger{}}
+        , symbols_{symbols}
+        , priority_{0}
+        , weight_{1.}
+        , sequence_{0}
+        , hits_{0}
+        , cached_{false}
+        , cachedResult_{false}
+        , cachedStamp_{0}
+    {
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Transition::test() const
+    {
+        if (parent_->recording_ == nullptr && parent_->replay_ == nullptr)
+            return testTrigger();
+
+        if (trigger_.isUnconditional())
+            return true;
+        if (parent_->replay_ != nullptr)
+            return parent_->replayOutcome(*this);
+
+        auto result = testTrigger();
+        parent_->recording_->addOutcome(sequence_, result);
+        return result;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Transition::testTrigger() const
+    {
+        if (trigger_.isUnconditional() || !trigger_.isEventDriven())
+            return evaluate();
+
+        auto stamp = trigger_.dependencyStamp();
+        if (!cached_ || stamp != cachedStamp_)
+        {
+            cachedResult_ = evaluate();
+            cachedStamp_ = stamp;
+            cached_ = true;
+        }
+        return cachedResult_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Transition::evaluate() const
+    {
+        auto* instrumentation = parent_->instrumentation_;
+        if (instrumentation == nullptr || trigger_.isUnconditional())
+            return trigger_.test();
+
+        auto start = Instrumentation::now();
+        auto result = trigger_.test();
+        instrumentation->recordGuard(sequence_, Instrumentation::now() - start);
+        return result;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Transition::isDormant() const
+    {
+        return
+            !trigger_.isUnconditional() &&
+            trigger_.isEventDriven() &&
+            cached_ &&
+            !cachedResult_ &&
+            cachedStamp_ == trigger_.dependencyStamp()
+        ;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Transition::perform() const
+    {
+        if (parent_->isObserved())
+            parent_->recordTransition(*this);
+        parent_->setState(to_);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    StringView Transition::getTargetName() const
+    {
+        return parent_->states_[to_].getName();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t Transition::getTarget() const
+    {
+        return to_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Trigger const& Transition::getTrigger() const
+    {
+        return trigger_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    boost::optional <SymbolSet> const& Transition::getSymbols() const
+    {
+        return symbols_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    int Transition::getPriority() const
+    {
+        return priority_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    double Transition::getWeight() const
+    {
+        return weight_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint64_t Transition::getHits() const
+    {
+        return hits_;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t Transition::getSequence() const
+    {
+        return sequence_;
     }
 //#####################################################################################################################
-}
+}
@@ -1,70 +1,130 @@
-#pragma once
-
-#include "automata_fwd.hpp"
-#include "trigger.hpp"
-#include "state.hpp"
-
-#include <unordered_set>
-
-namespace MiniAutomata
-{
-    /**
-     *  A transition describes a one way connection between two states.
-     */
-    class Transition
-    {
-    public:
-        Transition(Automaton* parent, std::size_t to, boost::optional <Trigger> const& trig);
-
-        /**
-         *  Test the trigger condition.
-         */
-        bool test() const;
-
-        /**
-         *  Does no testing, just performs the transition.
-         */
-        void perform() const;
-
-        /**
-         *  Returns the name of the state this transition points to.
-         */
-        std::string getTargetName() const;
-
-        /**
-         *  Returns the node position in the automaton.
-         */
-        std::size_t getTarget() const;
-
-    private:
-        Automaton* parent_;
-        std::size_t to_;
-        Trigger trigger_;
-    };
-
-    /**
-     *  A transition set composes a set of transitions that are active and selectable.
-     */
-    class TransitionSet
-    {
-    public:
-        using iterator = std::unordered_set <Transition*>::iterator;
-        using const_iterator = std::unordered_set <Transition*>::const_iterator;
-
-    public:
-        TransitionSet();
-        void insert(Transition* trans);
-        std::unordered_set <Transition*>::iterator begin();
-        std::unordered_set <Transition*>::iterator end();
-        std::unordered_set <Transition*>::const_iterator begin() const;
-        std::unordered_set <Transition*>::const_iterator end() const;
-        std::unordered_set <Transition*>::const_iterator cbegin() const;
-        std::unordered_set <Transition*>::const_iterator cend() const;
-        Transition* first();
-        bool empty() const;
-        std::size_t size() const;
-
-    private:
-        std::unordered_set <Transition*> transitions_;
-    };
-}
+#pragma once
+
+#include "automata_fwd.hpp"
+#include "trigger.hpp"
+#include "state.hpp"
+#include "symbols.hpp"
+#include "pointer_set.hpp"
+
+namespace MiniAutomata
+{
+    /**
+     *  Transitions with higher priority are tested first by Automaton::advanceFirstMatch.
+     *  Written into a transition chain: automat > "Idle" > Priority{2} > "Active";
+     */
+    struct Priority
+    {
+        int value;
+    };
+
+    /**
+     *  Random selection takes an active transition with a probability proportional to its weight.
+     *  Written into a transition chain: automat > "Idle" > Weight{0.25} > "Active";
+     *  Weights must be positive, the default is 1.
+     */
+    struct Weight
+    {
+        double value;
+    };
+
+    /**
+     *  A transition describes a one way connection between two states.
+     */
+    class Transition
+    {
+    public:
+        friend Automaton;
+        friend AutomatonBuilder;
+
+    public:
+        Transition(
+            Automaton* parent,
+            std::size_t to,
+            boost::optional <Trigger> const& trig,
+            boost::optional <SymbolSet> const& symbols = boost::none
+        );
+
+        /**
+         *  Test the trigger condition.
+         *  Event driven triggers are only evaluated again after one of their signals was notified.
+         */
+        bool test() const;
+
+        /**
+         *  Returns true, if the trigger is known to be false without evaluating it.
+         */
+        bool isDormant() const;
+
+        /**
+         *  Does no testing, just performs the transition.
+         */
+        void perform() const;
+
+        /**
+         *  Returns the name of the state this transition points to.
+         */
+        StringView getTargetName() const;
+
+        /**
+         *  Returns the node position in the automaton.
+         */
+        std::size_t getTarget() const;
+
+        /**
+         *  Returns the trigger guarding this transition.
+         */
+        Trigger const& getTrigger() const;
+
+        /**
+         *  Returns the input symbols this transition consumes, none for transitions taken by advance().
+         */
+        boost::optional <SymbolSet> const& getSymbols() const;
+
+        /**
+         *  Returns the priority, 0 unless set otherwise.
+         */
+        int getPriority() const;
+
+        /**
+         *  Returns the weight for random selection, 1 unless set otherwise.
+         */
+        double getWeight() const;
+
+        /**
+         *  Returns how often this transition was taken by Automaton::advanceFirstMatch.
+         */
+        std::uint64_t getHits() const;
+
+        /**
+         *  Returns the insertion sequence, which numbers the transitions of an automaton from 0.
+         *  It identifies the transition in instrumentation, whatever order freezing puts it in.
+         */
+        std::size_t getSequence() const;
+
+    private:
+        bool testTrigger() const;
+        bool evaluate() const;
+
+    private:
+        Automaton* parent_;
+        std::size_t to_;
+        Trigger trigger_;
+        boost::optional <SymbolSet> symbols_;
+        int priority_;
+        double weight_;
+
+        // Insertion order, breaks ties between equal priorities.
+        std::size_t sequence_;
+        std::uint64_t hits_;
+
+        // Last result of an event driven trigger.
+        mutable bool cached_;
+        mutable bool cachedResult_;
+        mutable std::uint64_t cachedStamp_;
+    };
+
+    /**
+     *  A transition set composes a set of transitions that are active and selectable.
+     */
+    using TransitionSet = PointerSet <Transition>;
+}
@@ -1,28 +1,138 @@
 #include "trigger.hpp"
-
+
 namespace MiniAutomata
 {
-//#####################################################################################################################
-    Trigger::Trigger(std::function <bool()> const& condition)
-        : condition_{condition}
-    {
-
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    Trigger::Trigger()
-        : condition_{[](){return true;}}
-    {
-
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    void Trigger::setCondition(std::function <bool()> const& condition)
-    {
-        condition_ = condition;
-    }
-//---------------------------------------------------------------------------------------------------------------------
-    bool Trigger::test() const
-    {
-        return condition_();
+//#####################################################################################################################
+    constexpr std::uint32_t Trigger::accept;
+    constexpr std::uint32_t Trigger::reject;
+//---------------------------------------------------------------------------------------------------------------------
+    Trigger::Trigger(std::function <bool()> const& condition)
+        : leaves_{}
+        , program_{}
+        , dependencies_{}
+    {
+        setCondition(condition);
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Trigger::Trigger()
+        : leaves_{}
+        , program_{}
+        , dependencies_{}
+    {
+
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Trigger::setCondition(std::function <bool()> const& condition)
+    {
+        leaves_.clear();
+        program_.clear();
+
+        // the signals declared belong to the old condition.
+        dependencies_.clear();
+        if (condition)
+        {
+            leaves_.push_back(condition);
+            program_.push_back({0, accept, reject});
+        }
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Trigger::test() const
+    {
+        if (program_.empty())
+            return true;
+
+        std::uint32_t next = 0;
+        do
+        {
+            auto const& instruction = program_[next];
+            next = leaves_[instruction.leaf]() ? instruction.onTrue : instruction.onFalse;
+        } while (next < program_.size());
+        return next == accept;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Trigger::isUnconditional() const
+    {
+        return program_.empty();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t Trigger::leafCount() const
+    {
+        return leaves_.size();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    void Trigger::chain(Trigger const& other, std::uint32_t outcome)
+    {
+        auto start = static_cast <std::uint32_t> (program_.size());
+        auto leafOffset = static_cast <std::uint32_t> (leaves_.size());
+
+        for (auto& instruction : program_)
+        {
+            if (instruction.onTrue == outcome)
+                instruction.onTrue = start;
+            if (instruction.onFalse == outcome)
+                instruction.onFalse = start;
+        }
+
+        auto relocate = [start](std::uint32_t target) {
+            return target == accept || target == reject ? target : target + start;
+        };
+
+        leaves_.insert(std::end(leaves_), std::begin(other.leaves_), std::end(other.leaves_));
+        program_.reserve(program_.size() + other.program_.size());
+        for (auto const& instruction : other.program_)
+            program_.push_back({instruction.leaf + leafOffset, relocate(instruction.onTrue), relocate(instruction.onFalse)});
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Trigger& Trigger::dependsOn(Signal const& signal)
+    {
+        dependencies_.push_back(&signal);
+        return *this;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    bool Trigger::isEventDriven() const
+    {
+        return isUnconditional() || !dependencies_.empty();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint64_t Trigger::dependencyStamp() const
+    {
+        // versions only grow, so the sum changes whenever any of them changes.
+        std::uint64_t stamp = 0;
+        for (auto const* signal : dependencies_)
+            stamp += signal->version();
+        return stamp;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Trigger operator&&(Trigger const& lhs, Trigger const& rhs)
+    {
+        if (lhs.isUnconditional())
+            return rhs;
+        if (rhs.isUnconditional())
+            return lhs;
+
+        Trigger result = lhs;
+        result.chain(rhs, Trigger::accept);
+        if (lhs.isEventDriven() && rhs.isEventDriven())
+            result.dependencies_.insert(std::end(result.dependencies_), std::begin(rhs.dependencies_), std::end(rhs.dependencies_));
+        else
+            result.dependencies_.clear();
+        return result;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    Trigger operator||(Trigger const& lhs, Trigger const& rhs)
+    {
+        if (lhs.isUnconditional())
+            return lhs;
+        if (rhs.isUnconditional())
+            return rhs;
+
+        Trigger result = lhs;
+        result.chain(rhs, Trigger::reject);
+        if (lhs.isEventDriven() && rhs.isEventDriven())
+            result.dependencies_.insert(std::end(result.dependencies_), std::begin(rhs.dependencies_), std::end(rhs.dependencies_));
+        else
+            result.dependencies_.clear();
+        return result;
     }
 //#####################################################################################################################
-}
+}
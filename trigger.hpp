@@ -1,25 +1,98 @@
-#pragma once
-
-#include <functional>
-#include <memory>
-
-namespace MiniAutomata
-{
-    /**
-     *  A trigger is the activation condition for a transition.
-     *  Despite its name, a trigger does not automatically perform the transition.
-     */
-    class Trigger
-    {
-    public:
-        Trigger(std::function <bool()> const& condition);
-        Trigger();
-
-        void setCondition(std::function <bool()> const& condition);
-
-        bool test() const;
-
-    private:
-        std::function <bool()> condition_;
-    };
-}
+#pragma once
+
+#include "signal.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace MiniAutomata
+{
+    /**
+     *  A trigger is the activation condition for a transition.
+     *  Despite its name, a trigger does not automatically perform the transition.
+     *  Combined triggers are kept as a flat program over their leaf conditions: each instruction tests one leaf
+     *  and jumps to another instruction or to the result, depending on the outcome. Testing is a single loop
+     *  without recursion or allocation, and combining copies the programs instead of nesting them.
+     */
+    class Trigger
+    {
+    public:
+        Trigger(std::function <bool()> const& condition);
+        Trigger();
+
+        /**
+         *  Replaces the whole condition. Signals declared with dependsOn are dropped with it,
+         *  declare the ones of the new condition again.
+         */
+        void setCondition(std::function <bool()> const& condition);
+
+        bool test() const;
+
+        /**
+         *  Returns true, if this trigger has no condition and is always active.
+         */
+        bool isUnconditional() const;
+
+        /**
+         *  Declares that the condition only changes its result when the signal is notified.
+         *  A trigger that declares its signals is only re-evaluated after one of them changed.
+         */
+        Trigger& dependsOn(Signal const& signal);
+
+        /**
+         *  Returns true, if the result of test() only changes with the declared signals.
+         *  Unconditional triggers are always event driven.
+         */
+        bool isEventDriven() const;
+
+        /**
+         *  Returns a stamp that changes whenever one of the declared signals is notified.
+         */
+        std::uint64_t dependencyStamp() const;
+
+        /**
+         *  Returns the amount of leaf conditions.
+         */
+        std::size_t leafCount() const;
+
+        /**
+         *  Combines two triggers, so that both conditions have to be true.
+         *  The right hand side is only tested if the left hand side is true.
+         */
+        friend Trigger operator&&(Trigger const& lhs, Trigger const& rhs);
+
+        /**
+         *  Combines two triggers, so that either condition has to be true.
+         *  The right hand side is only tested if the left hand side is false.
+         */
+        friend Trigger operator||(Trigger const& lhs, Trigger const& rhs);
+
+    private:
+        /**
+         *  Tests leaf 'leaf', continues with instruction 'onTrue' or 'onFalse'.
+         *  Jump targets past the program are results, see accept and reject.
+         */
+        struct Instruction
+        {
+            std::uint32_t leaf;
+            std::uint32_t onTrue;
+            std::uint32_t onFalse;
+        };
+
+        constexpr static std::uint32_t accept = 0xFFFFFFFFu;
+        constexpr static std::uint32_t reject = 0xFFFFFFFEu;
+
+        /**
+         *  Redirects all jumps to the result 'outcome' to the start of other's program, which is appended.
+         */
+        void chain(Trigger const& other, std::uint32_t outcome);
+
+    private:
+        // An empty program is unconditional.
+        std::vector <std::function <bool()>> leaves_;
+        std::vector <Instruction> program_;
+        std::vector <Signal const*> dependencies_;
+    };
+}
@@ -0,0 +1,167 @@
+#include "walks.hpp"
+#include "definition.hpp"
+#include "predicate.hpp"
+#include "random.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace MiniAutomata
+{
+	using namespace std::string_literals;
+
+    namespace
+    {
+        // Walks are handed out in blocks, so threads rarely touch the shared counter.
+        constexpr std::uint64_t blockSize = 256;
+    }
+//#####################################################################################################################
+    double WalkStatistics::meanPathLength() const
+    {
+        return walks == 0 ? 0. : static_cast <double> (steps) / static_cast <double> (walks);
+    }
+//#####################################################################################################################
+    WalkSimulator::WalkSimulator(std::shared_ptr <AutomatonDefinition const> definition, std::size_t threadCount)
+        : definition_{std::move(definition)}
+        , threadCount_{std::max <std::size_t> (threadCount, 1)}
+    {
+        if (!definition_)
+            throw std::invalid_argument("walk simulator requires a definition");
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::uint64_t WalkSimulator::streamSeed(std::uint64_t seed, std::uint64_t walk)
+    {
+        // SplitMix64 is counter based, mixing the walk index gives independent looking streams.
+        std::uint64_t state = seed ^ (walk * 0xd1b54a32d192ed03ull);
+        SplitMix64 mix{state};
+        return mix();
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    WalkStatistics WalkSimulator::run(std::uint64_t walks, std::size_t maxSteps, std::uint64_t seed, std::size_t start) const
+    {
+        auto stateCount = definition_->stateCount();
+        if (start >= stateCount)
+            throw std::invalid_argument(("no such state with index '"s + std::to_string(start) + "' in definition").c_str());
+
+        auto makeStatistics = [&]() {
+            return WalkStatistics{
+                0,
+                0,
+                std::vector <std::uint64_t> (stateCount, 0),
+                std::vector <std::uint64_t> (stateCount, 0),
+                std::vector <std::uint64_t> {}
+            };
+        };
+
+        auto workers = static_cast <std::size_t> (std::min <std::uint64_t> (threadCount_, (walks + blockSize - 1) / blockSize));
+        workers = std::max <std::size_t> (workers, 1);
+
+        std::vector <WalkStatistics> partials;
+        partials.reserve(workers);
+        for (std::size_t i = 0; i != workers; ++i)
+            partials.push_back(makeStatistics());
+
+        std::atomic <std::uint64_t> nextBlock{0};
+        std::mutex errorMutex;
+        std::exception_ptr error;
+
+        auto work = [&](std::size_t worker) {
+            try
+            {
+                // counters written per walk stay local, the partials of neighbouring workers share cache lines.
+                auto& statistics = partials[worker];
+                std::uint64_t walked = 0;
+                std::uint64_t totalSteps = 0;
+                for (;;)
+                {
+                    auto first = nextBlock.fetch_add(1, std::memory_order_relaxed) * blockSize;
+                    if (first >= walks)
+                    {
+                        statistics.walks = walked;
+                        statistics.steps = totalSteps;
+                        return;
+                    }
+
+                    auto last = std::min(first + blockSize, walks);
+                    for (auto walk = first; walk != last; ++walk)
+                    {
+                        auto instance = definition_->makeInstance(streamSeed(seed, walk), start);
+                        ++statistics.visits[instance.state];
+
+                        // every step is a new epoch for shared predicates, like a step of a batch.
+                        std::size_t steps = 0;
+                        for (;;)
+                        {
+                            SharedPredicate::beginEpoch();
+                            if (steps == maxSteps || !definition_->advance(instance))
+                                break;
+                            ++steps;
+                            ++statistics.visits[instance.state];
+                        }
+
+                        ++statistics.terminalStates[instance.state];
+
+                        // the histogram grows with the longest walk, not with the step limit.
+                        auto& lengths = statistics.pathLengths;
+                        if (steps >= lengths.size())
+                        {
+                            if (steps >= lengths.max_size())
+                                throw std::length_error("walk too long for the path length histogram");
+                            lengths.resize(steps + 1, 0);
+                        }
+                        ++lengths[steps];
+                        totalSteps += steps;
+                    }
+                    walked += last - first;
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard <std::mutex> lock{errorMutex};
+                if (!error)
+                    error = std::current_exception();
+
+                // let the other workers run out of walks.
+                nextBlock.store((walks + blockSize - 1) / blockSize, std::memory_order_relaxed);
+            }
+        };
+
+        std::vector <std::thread> threads;
+        threads.reserve(workers - 1);
+        for (std::size_t worker = 1; worker < workers; ++worker)
+            threads.emplace_back(work, worker);
+        work(0);
+        for (auto& thread : threads)
+            thread.join();
+
+        if (error)
+            std::rethrow_exception(error);
+
+        auto result = makeStatistics();
+        for (auto const& partial : partials)
+            result.pathLengths.resize(std::max(result.pathLengths.size(), partial.pathLengths.size()), 0);
+        for (auto const& partial : partials)
+        {
+            result.walks += partial.walks;
+            result.steps += partial.steps;
+            for (std::size_t state = 0; state != stateCount; ++state)
+            {
+                result.visits[state] += partial.visits[state];
+                result.terminalStates[state] += partial.terminalStates[state];
+            }
+            for (std::size_t length = 0; length != partial.pathLengths.size(); ++length)
+                result.pathLengths[length] += partial.pathLengths[length];
+        }
+        return result;
+    }
+//---------------------------------------------------------------------------------------------------------------------
+    std::size_t WalkSimulator::threadCount() const
+    {
+        return threadCount_;
+    }
+//#####################################################################################################################
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "automata_fwd.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace MiniAutomata
+{
+    /**
+     *  Aggregated outcome of many random walks.
+     */
+    struct WalkStatistics
+    {
+        std::uint64_t walks;
+        std::uint64_t steps;
+
+        // How often walks were in each state, the start included.
+        std::vector <std::uint64_t> visits;
+
+        // How many walks ended in each state.
+        std::vector <std::uint64_t> terminalStates;
+
+        // How many walks made exactly i steps, walks cut off by the step limit count at the limit.
+        // Ends with the longest walk made.
+        std::vector <std::uint64_t> pathLengths;
+
+        /**
+         *  Returns the average amount of steps per walk.
+         */
+        double meanPathLength() const;
+    };
+
+    /**
+     *  Runs many independent random walks over one definition on all cores.
+     *  Walk i draws its random numbers from a stream that only depends on the seed and i,
+     *  so results do not depend on the thread count or on which thread ran which walk.
+     *  Every thread accumulates into its own statistics, which are merged once at the end.
+     *  Guards and actions are called concurrently and have to be thread safe.
+     */
+    class WalkSimulator
+    {
+    public:
+        /**
+         *  @param threadCount The amount of threads walking, including the thread calling run().
+         */
+        explicit WalkSimulator(
+            std::shared_ptr <AutomatonDefinition const> definition,
+            std::size_t threadCount = std::thread::hardware_concurrency()
+        );
+
+        /**
+         *  Walks from the start state until no transition is active or maxSteps steps were made.
+         *  Every step begins a new epoch for shared predicates.
+         *  Rethrows the first exception thrown by a guard or action.
+         */
+        WalkStatistics run(std::uint64_t walks, std::size_t maxSteps, std::uint64_t seed, std::size_t start = 0) const;
+
+        /**
+         *  Returns the amount of threads walking.
+         */
+        std::size_t threadCount() const;
+
+        /**
+         *  Returns the random generator state walk 'walk' starts with.
+         */
+        static std::uint64_t streamSeed(std::uint64_t seed, std::uint64_t walk);
+
+    private:
+        std::shared_ptr <AutomatonDefinition const> definition_;
+        std::size_t threadCount_;
+    };
+}